@@ -0,0 +1,157 @@
+#include "bench_log.h"
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#include "mbedtls/base64.h"
+
+// Entries per CSV_BLOG line: 48 * 12 bytes -> 768 base64 characters
+#define BENCH_LOG_FRAME_ENTRIES 48
+#define BENCH_LOG_ENTRY_BYTES 12
+
+#define BENCH_LOG_FLAG_CYCLES 0x1
+#define BENCH_LOG_FLAG_ESP_TIMER 0x2
+
+typedef struct {
+    uint32_t iter;
+    uint64_t us;
+    uint64_t cycles;
+    uint64_t ns;
+} bench_log_entry_t;
+
+static bench_log_entry_t *s_entries;
+static size_t s_capacity;
+static size_t s_count;
+static size_t s_spills;
+static bench_log_format_t s_format = BENCH_LOG_CSV;
+
+// Labels of the pending rows
+static const char *s_op;
+static const char *s_exp;
+static size_t s_bits;
+static bool s_cycles;
+
+static void log_print_csv(const char *op, size_t bits, const char *exp_label,
+                          const bench_log_entry_t *e, bool cycles) {
+    printf("CSV,%s,%zu,%s,%" PRIu32 ",%" PRIu64 "\n", op, bits, exp_label, e->iter, e->us);
+    if (cycles) {
+        printf("CSV_CYC,%s,%zu,%s,%" PRIu32 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n",
+               op, bits, exp_label, e->iter, e->us, e->cycles, e->ns);
+    }
+}
+
+static void put_le(uint8_t *p, uint64_t v, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+// CSV_BLOG,op,bits,exp,flags,mhz,first_iter,count,payload,crc32. The
+// payload is count little-endian records of us (u32) followed, when
+// flags has BENCH_LOG_FLAG_CYCLES, by cycles (u64); ns is recomputed
+// from cycles and mhz, or from us under BENCH_LOG_FLAG_ESP_TIMER.
+static void log_print_frame(const bench_log_entry_t *e, size_t n) {
+    // Static: flush runs on the benchmark task only, and keeps ~1.3 KB off its stack
+    static uint8_t raw[BENCH_LOG_FRAME_ENTRIES * BENCH_LOG_ENTRY_BYTES];
+    static unsigned char text[((sizeof(raw) + 2) / 3) * 4 + 1];
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++) {
+        put_le(raw + len, e[i].us, 4);
+        len += 4;
+        if (s_cycles) {
+            put_le(raw + len, e[i].cycles, 8);
+            len += 8;
+        }
+    }
+
+    size_t olen = 0;
+    if (mbedtls_base64_encode(text, sizeof(text), &olen, raw, len) != 0) {
+        printf("CSV_BLOG encode failed\n");
+        return;
+    }
+    unsigned flags = (s_cycles ? BENCH_LOG_FLAG_CYCLES : 0) |
+                     (bench_timer_source() == BENCH_TIMER_ESP_TIMER ? BENCH_LOG_FLAG_ESP_TIMER : 0);
+    printf("CSV_BLOG,%s,%zu,%s,%u,%" PRIu32 ",%" PRIu32 ",%zu,%s,%08" PRIx32 "\n",
+           s_op, s_bits, s_exp, flags, bench_timer_cpu_mhz(), e[0].iter, n, (const char *)text,
+           esp_rom_crc32_le(0, raw, (uint32_t)len));
+}
+
+bool bench_log_init(size_t capacity, bench_log_format_t format) {
+    if (capacity == 0) {
+        return false;
+    }
+    bench_log_flush();
+    heap_caps_free(s_entries);
+    s_entries = heap_caps_malloc(capacity * sizeof(bench_log_entry_t), MALLOC_CAP_DEFAULT);
+    s_capacity = s_entries ? capacity : 0;
+    s_count = 0;
+    s_spills = 0;
+    s_format = format;
+    return s_entries != NULL;
+}
+
+void bench_log_set_format(bench_log_format_t format) {
+    bench_log_flush();
+    s_format = format;
+}
+
+bench_log_format_t bench_log_format(void) {
+    return s_format;
+}
+
+size_t bench_log_spills(void) {
+    return s_spills;
+}
+
+void bench_log_flush(void) {
+    if (s_count == 0) {
+        return;
+    }
+    if (s_format == BENCH_LOG_CSV) {
+        for (size_t i = 0; i < s_count; i++) {
+            log_print_csv(s_op, s_bits, s_exp, &s_entries[i], s_cycles);
+        }
+    } else {
+        // A frame holds a consecutive run of iterations
+        size_t first = 0;
+        for (size_t i = 1; i <= s_count; i++) {
+            if (i == s_count || i - first == BENCH_LOG_FRAME_ENTRIES ||
+                s_entries[i].iter != s_entries[i - 1].iter + 1) {
+                log_print_frame(&s_entries[first], i - first);
+                first = i;
+            }
+        }
+    }
+    s_count = 0;
+}
+
+void bench_log_record(const char *op, size_t bits, const char *exp_label, size_t iter,
+                      uint64_t us, const bench_sample_t *s) {
+    bench_log_entry_t e = {
+        .iter = (uint32_t)iter,
+        .us = us,
+        .cycles = s ? s->cycles : 0,
+        .ns = s ? s->ns : 0,
+    };
+    if (!s_entries) {
+        log_print_csv(op, bits, exp_label, &e, s != NULL);
+        return;
+    }
+
+    if (s_count > 0 && (bits != s_bits || (s != NULL) != s_cycles ||
+                        strcmp(op, s_op) != 0 || strcmp(exp_label, s_exp) != 0)) {
+        bench_log_flush();
+    }
+    if (s_count == s_capacity) {
+        bench_log_flush();
+        s_spills++;
+    }
+    s_op = op;
+    s_exp = exp_label;
+    s_bits = bits;
+    s_cycles = (s != NULL);
+    s_entries[s_count++] = e;
+}
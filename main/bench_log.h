@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bench_timer.h"
+
+// Deferred per-iteration sample log. Timed loops record into a buffer
+// allocated once up front and the rows are printed by bench_log_flush after
+// the loop, so no UART output (and no UART interrupt) lands between two
+// measurements. Flush prints either the usual CSV / CSV_CYC rows or compact
+// base64 frames that tools/decode_bench_log.py turns back into the same
+// rows. Without bench_log_init every record is printed immediately, as the
+// loops did before.
+typedef enum {
+    BENCH_LOG_CSV,
+    BENCH_LOG_BASE64,
+} bench_log_format_t;
+
+#define BENCH_LOG_DEFAULT_CAPACITY 256
+
+bool bench_log_init(size_t capacity, bench_log_format_t format);
+void bench_log_set_format(bench_log_format_t format);
+bench_log_format_t bench_log_format(void);
+
+// One row for iteration iter of op. s carries cycles and ns for a CSV_CYC
+// row, or is NULL for µs-only ops. The label strings must stay valid until
+// the next flush. A record for a different op/bits/exp flushes the pending
+// rows first; a full buffer is flushed in place and counted as a spill.
+void bench_log_record(const char *op, size_t bits, const char *exp_label, size_t iter,
+                      uint64_t us, const bench_sample_t *s);
+void bench_log_flush(void);
+size_t bench_log_spills(void);
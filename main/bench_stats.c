@@ -0,0 +1,128 @@
+#include "bench_stats.h"
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <math.h>
+
+static size_t hist_bucket(uint64_t v) {
+    if (v < 2 * BENCH_HIST_SUB) {
+        return (size_t)v;
+    }
+    if (v >> BENCH_HIST_VALUE_BITS) {
+        return BENCH_HIST_BUCKETS - 1;
+    }
+    unsigned msb = 63u - (unsigned)__builtin_clzll(v);
+    unsigned shift = msb - BENCH_HIST_SUB_BITS;
+    size_t sub = (size_t)(v >> shift) & (BENCH_HIST_SUB - 1);
+    return 2 * BENCH_HIST_SUB + (size_t)(msb - BENCH_HIST_SUB_BITS - 1) * BENCH_HIST_SUB + sub;
+}
+
+// [lo, hi) of a bucket; the overflow bucket ends at the observed max
+static void hist_bounds(const bench_stats_t *s, size_t i, uint64_t *lo, uint64_t *hi) {
+    if (i < 2 * BENCH_HIST_SUB) {
+        *lo = i;
+        *hi = i + 1;
+        return;
+    }
+    if (i == BENCH_HIST_BUCKETS - 1) {
+        *lo = 1ull << BENCH_HIST_VALUE_BITS;
+        *hi = s->max + 1;
+        return;
+    }
+    size_t k = i - 2 * BENCH_HIST_SUB;
+    unsigned shift = (unsigned)(k / BENCH_HIST_SUB) + 1;
+    uint64_t sub = k % BENCH_HIST_SUB;
+    *lo = (BENCH_HIST_SUB + sub) << shift;
+    *hi = (BENCH_HIST_SUB + sub + 1) << shift;
+}
+
+void bench_stats_init(bench_stats_t *s) {
+    s->min = UINT64_MAX;
+    s->max = 0;
+    s->total = 0;
+    s->mean = 0.0;
+    s->m2 = 0.0;
+    s->count = 0;
+    for (size_t i = 0; i < BENCH_HIST_BUCKETS; i++) {
+        s->hist[i] = 0;
+    }
+}
+
+void bench_stats_update(bench_stats_t *s, uint64_t value) {
+    if (value < s->min) s->min = value;
+    if (value > s->max) s->max = value;
+    s->total += value;
+    s->count++;
+
+    double delta = (double)value - s->mean;
+    s->mean += delta / (double)s->count;
+    s->m2 += delta * ((double)value - s->mean);
+
+    size_t b = hist_bucket(value);
+    if (s->hist[b] != UINT16_MAX) {
+        s->hist[b]++;
+    }
+}
+
+double bench_stats_avg(const bench_stats_t *s) {
+    if (s->count == 0) return 0.0;
+    return (double)s->total / (double)s->count;
+}
+
+double bench_stats_stddev(const bench_stats_t *s) {
+    if (s->count == 0) return 0.0;
+    double var = s->m2 / (double)s->count;
+    return (var > 0.0) ? sqrt(var) : 0.0;
+}
+
+double bench_stats_quantile(const bench_stats_t *s, double q) {
+    if (s->count == 0) return 0.0;
+    if (q < 0.0) q = 0.0;
+    if (q > 1.0) q = 1.0;
+
+    size_t total = 0;
+    for (size_t i = 0; i < BENCH_HIST_BUCKETS; i++) {
+        total += s->hist[i];
+    }
+    double target = q * (double)total;
+    size_t below = 0;
+    for (size_t i = 0; i < BENCH_HIST_BUCKETS; i++) {
+        if (s->hist[i] == 0) {
+            continue;
+        }
+        if ((double)(below + s->hist[i]) >= target) {
+            uint64_t lo, hi;
+            hist_bounds(s, i, &lo, &hi);
+            if (hi - lo == 1) {
+                return (double)lo;
+            }
+            double frac = (target - (double)below) / (double)s->hist[i];
+            double v = (double)lo + frac * (double)(hi - lo);
+            if (v < (double)s->min) v = (double)s->min;
+            if (v > (double)s->max) v = (double)s->max;
+            return v;
+        }
+        below += s->hist[i];
+    }
+    return (double)s->max;
+}
+
+void bench_stats_csv_hist(const char *op, size_t size, const char *exp_label,
+                          const char *unit, const bench_stats_t *s) {
+    if (s->count == 0) {
+        return;
+    }
+    printf("CSV_PCTL,%s,%zu,%s,%s,%zu,%.1f,%.1f,%.1f,%.1f\n",
+           op, size, exp_label, unit, s->count,
+           bench_stats_quantile(s, 0.50), bench_stats_quantile(s, 0.90),
+           bench_stats_quantile(s, 0.99), bench_stats_quantile(s, 0.999));
+    for (size_t i = 0; i < BENCH_HIST_BUCKETS; i++) {
+        if (s->hist[i] == 0) {
+            continue;
+        }
+        uint64_t lo, hi;
+        hist_bounds(s, i, &lo, &hi);
+        printf("CSV_HIST,%s,%zu,%s,%s,%" PRIu64 ",%" PRIu64 ",%u\n",
+               op, size, exp_label, unit, lo, hi, (unsigned)s->hist[i]);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Streaming latency statistics shared by the RSA and SHA benchmarks.
+// Mean and variance use Welford's update; quantiles come from a
+// log-bucketed histogram (8 sub-buckets per power of two, exact below 16),
+// so p50..p99.9 are within one bucket width (12.5% of the value) without
+// storing samples. Values are µs or cycles depending on the caller, so
+// the fields carry no unit.
+#define BENCH_HIST_SUB_BITS 3
+#define BENCH_HIST_SUB (1u << BENCH_HIST_SUB_BITS)
+#define BENCH_HIST_VALUE_BITS 32
+// 16 exact buckets, then 8 per octave from 2^4 to 2^32, then one overflow
+#define BENCH_HIST_BUCKETS (2 * BENCH_HIST_SUB + (BENCH_HIST_VALUE_BITS - BENCH_HIST_SUB_BITS - 1) * BENCH_HIST_SUB + 1)
+
+typedef struct {
+    uint64_t min;
+    uint64_t max;
+    uint64_t total;
+    double mean;
+    double m2;
+    size_t count;
+    // Saturates at UINT16_MAX per bucket, far above any run's iterations
+    uint16_t hist[BENCH_HIST_BUCKETS];
+} bench_stats_t;
+
+void bench_stats_init(bench_stats_t *s);
+void bench_stats_update(bench_stats_t *s, uint64_t value);
+double bench_stats_avg(const bench_stats_t *s);
+double bench_stats_stddev(const bench_stats_t *s);
+// q in [0, 1], interpolated inside the bucket and clamped to [min, max]
+double bench_stats_quantile(const bench_stats_t *s, double q);
+
+// CSV_PCTL row plus one CSV_HIST row per non-empty bucket. size is the
+// operand bits for RSA ops and the message bytes for hashes.
+void bench_stats_csv_hist(const char *op, size_t size, const char *exp_label,
+                          const char *unit, const bench_stats_t *s);
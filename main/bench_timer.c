@@ -0,0 +1,114 @@
+#include "bench_timer.h"
+
+#include "sdkconfig.h"
+#include "esp_timer.h"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_cpu.h"
+#include "esp_private/esp_clk.h"
+#endif
+
+#define BENCH_TIMER_CALIBRATION_RUNS 64
+// The linux target has no CPU cycle counter: esp_timer only, with cycles
+// counted at the ESP32's nominal clock so the columns stay comparable
+#define BENCH_TIMER_HOST_MHZ 240
+
+#if CONFIG_IDF_TARGET_LINUX
+static bench_timer_source_t s_source = BENCH_TIMER_ESP_TIMER;
+#else
+static bench_timer_source_t s_source = BENCH_TIMER_CYCLE_COUNTER;
+#endif
+static uint32_t s_overhead_cycles;
+static uint32_t s_cpu_mhz;
+
+static uint32_t timer_cycles(void) {
+#if CONFIG_IDF_TARGET_LINUX
+    return 0;
+#else
+    return (uint32_t)esp_cpu_get_cycle_count();
+#endif
+}
+
+static uint32_t timer_cpu_mhz(void) {
+    if (s_cpu_mhz == 0) {
+#if CONFIG_IDF_TARGET_LINUX
+        s_cpu_mhz = BENCH_TIMER_HOST_MHZ;
+#else
+        s_cpu_mhz = (uint32_t)(esp_clk_cpu_freq() / 1000000);
+#endif
+    }
+    return s_cpu_mhz;
+}
+
+// esp_timer first and the counter last on start, the reverse on stop, so
+// the cycle window is as tight as the calls allow
+void bench_timer_start(bench_timer_t *t) {
+    t->start_us = esp_timer_get_time();
+    t->start_cycles = timer_cycles();
+}
+
+void bench_timer_stop(const bench_timer_t *t, bench_sample_t *out) {
+    uint32_t end_cycles = timer_cycles();
+    int64_t end_us = esp_timer_get_time();
+    uint32_t mhz = timer_cpu_mhz();
+
+    out->us = (uint64_t)(end_us - t->start_us);
+    if (s_source == BENCH_TIMER_ESP_TIMER) {
+        out->cycles = out->us * mhz;
+        out->ns = out->us * 1000;
+        return;
+    }
+
+    // The 32-bit counter wraps every 2^32 / f seconds (about 18 s at
+    // 240 MHz). Unsigned subtraction covers one wrap; esp_timer says how
+    // many more whole periods went by.
+    uint64_t cycles = (uint32_t)(end_cycles - t->start_cycles);
+    uint64_t expected = out->us * mhz;
+    if (expected > cycles + (1ull << 31)) {
+        cycles += ((expected - cycles + (1ull << 31)) >> 32) << 32;
+    }
+    cycles = (cycles > s_overhead_cycles) ? cycles - s_overhead_cycles : 0;
+    out->cycles = cycles;
+    out->ns = (mhz > 0) ? cycles * 1000 / mhz : 0;
+}
+
+void bench_timer_init(bench_timer_source_t source) {
+#if CONFIG_IDF_TARGET_LINUX
+    source = BENCH_TIMER_ESP_TIMER;
+#endif
+    s_source = source;
+    s_overhead_cycles = 0;
+    timer_cpu_mhz();
+    if (source != BENCH_TIMER_CYCLE_COUNTER) {
+        return;
+    }
+
+    // Back-to-back start/stop: the minimum is the fixed cost every
+    // measurement includes
+    uint64_t min_cycles = UINT64_MAX;
+    for (int i = 0; i < BENCH_TIMER_CALIBRATION_RUNS; i++) {
+        bench_timer_t t;
+        bench_sample_t s;
+        bench_timer_start(&t);
+        bench_timer_stop(&t, &s);
+        if (s.cycles < min_cycles) {
+            min_cycles = s.cycles;
+        }
+    }
+    s_overhead_cycles = (uint32_t)min_cycles;
+}
+
+bench_timer_source_t bench_timer_source(void) {
+    return s_source;
+}
+
+const char *bench_timer_source_name(void) {
+    return (s_source == BENCH_TIMER_CYCLE_COUNTER) ? "ccount" : "esp_timer";
+}
+
+uint32_t bench_timer_overhead_cycles(void) {
+    return s_overhead_cycles;
+}
+
+uint32_t bench_timer_cpu_mhz(void) {
+    return timer_cpu_mhz();
+}
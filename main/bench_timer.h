@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Timing source for the benchmarks. Every sample carries the esp_timer µs
+// the CSV rows always had, plus cycles and ns from the selected source:
+// the CPU cycle counter, corrected for wraparound and for the calibrated
+// cost of the start/stop calls themselves, or esp_timer alone with cycles
+// derived from µs (for comparison, or where the counter is unusable).
+typedef enum {
+    BENCH_TIMER_CYCLE_COUNTER,
+    BENCH_TIMER_ESP_TIMER,
+} bench_timer_source_t;
+
+typedef struct {
+    int64_t start_us;
+    uint32_t start_cycles;
+} bench_timer_t;
+
+typedef struct {
+    uint64_t us;
+    uint64_t cycles;
+    uint64_t ns;
+} bench_sample_t;
+
+// Selects the source and calibrates the start/stop overhead. Call once
+// before the benchmarks; until then the cycle counter is used uncalibrated.
+void bench_timer_init(bench_timer_source_t source);
+bench_timer_source_t bench_timer_source(void);
+const char *bench_timer_source_name(void);
+uint32_t bench_timer_overhead_cycles(void);
+uint32_t bench_timer_cpu_mhz(void);
+
+void bench_timer_start(bench_timer_t *t);
+void bench_timer_stop(const bench_timer_t *t, bench_sample_t *out);
@@ -1,10 +1,31 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_system.h"
-#include "esp_task_wdt.h"
 #include "rsa_hw.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include "rsa_hal_model.h"
+#else
+#include "esp_task_wdt.h"
 #include "sha_benchmark.h"
+#endif
+#include "bench_timer.h"
+#include "bench_log.h"
+
+// Op counts from the accelerator model on the linux target, one row per suite
+static void report_model_counters(size_t bits) {
+#if CONFIG_IDF_TARGET_LINUX
+    rsa_model_counters_t c;
+    rsa_model_get_counters(&c);
+    printf("CSV_MODEL,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu\n", bits, c.montmul, c.plainmul, c.mont_hw_op,
+           c.mul_mod_hw_op, c.enables, c.words_written, c.words_read, c.interrupts);
+    rsa_model_reset_counters();
+#else
+    (void)bits;
+#endif
+}
 
 void app_main(void) {
     printf("\n\n");
@@ -41,6 +62,15 @@ void app_main(void) {
         return;
     }
 
+    // Full-size operands through the context path, against mbedtls
+    const size_t check_bits[] = {1024, 2048, 3072, 4096};
+    for (size_t i = 0; i < sizeof(check_bits) / sizeof(check_bits[0]); i++) {
+        if (!verify_hw_sw_full(check_bits[i], 2)) {
+            printf("Full-size checks failed! Stopping.\n");
+            return;
+        }
+    }
+
     vTaskDelay(1000 / portTICK_PERIOD_MS);
 
     // Stage 3: Debug simple hardware test
@@ -57,12 +87,35 @@ void app_main(void) {
     printf("Stage 4: Performance Benchmarks\n");
     printf("══════════════════════════════════════════\n");
 
+#if CONFIG_IDF_TARGET_LINUX
+    printf("Linux target: RSA accelerator is the software model, timings are host timings\n");
+    printf("CSV_MODEL_HEADER,bits,montmul,plainmul,mont_hw_op,mul_mod_hw_op,enables,words_written,words_read,interrupts\n");
+    rsa_model_reset_counters();
+#else
     if (esp_task_wdt_deinit() == ESP_OK) {
         printf("Task WDT disabled for benchmarking\n");
     }
+#endif
 
     printf("CSV_HEADER,op,bits,exp,iter,us\n");
     printf("CSV_SUMMARY_HEADER,op,bits,exp,iter,success,avg_us,min_us,max_us,stddev_us\n");
+    printf("CSV_HEAP_HEADER,op,bits,exp,success,heap_calls,per_op\n");
+    printf("CSV_CYC_HEADER,op,bits,exp,iter,us,cycles,ns\n");
+    printf("CSV_CYC_SUMMARY_HEADER,op,bits,exp,source,success,avg_cycles,min_cycles,max_cycles,avg_ns\n");
+    bench_timer_init(BENCH_TIMER_CYCLE_COUNTER);
+    printf("Timer: %s, %" PRIu32 " MHz, %" PRIu32 " cycles overhead subtracted\n",
+           bench_timer_source_name(), bench_timer_cpu_mhz(), bench_timer_overhead_cycles());
+    // Per-iteration rows are held until each timed loop ends. BENCH_LOG_BASE64
+    // prints CSV_BLOG frames instead; decode with tools/decode_bench_log.py.
+    if (!bench_log_init(BENCH_LOG_DEFAULT_CAPACITY, BENCH_LOG_CSV)) {
+        printf("Sample log allocation failed, printing rows inline\n");
+    }
+    printf("CSV_BLOG_HEADER,op,bits,exp,flags,mhz,first_iter,count,payload,crc32\n");
+    printf("CSV_JITTER_HEADER,bits,mode,iter,avg_cycles,stddev_cycles,p50_cycles,p99_cycles,wall_us\n");
+    printf("CSV_OPS_HEADER,op,bits,exp,calls,montmuls,squarings,enables,disables,operand_loads,modulus_loads,result_reads,bytes_copied\n");
+    printf("CSV_SPEEDUP_HEADER,op,bits,exp,iter,ctx_us,mbedtls_us,mbedtls_sw_us,vs_mbedtls,vs_mbedtls_sw\n");
+    printf("CSV_SWEEP_HEADER,op,bits,exp,words,hw_words,pad_bits,iter,avg_us,min_us,plateau\n");
+    rsa_heap_counter_install();
 
     const size_t iter_mult_2048 = 20;
     const size_t iter_mult_4096 = 50;
@@ -70,21 +123,54 @@ void app_main(void) {
     const size_t iter_exp_small_4096 = 20;
     const size_t iter_exp_full_2048 = 10;
     const size_t iter_exp_full_4096 = 50;
+    // Async, fixed-base, multi-exp and CRT run several full exponentiations
+    // per iteration, and CRT generates its primes on the device
+    const size_t iter_exp_variants_2048 = 3;
+    const size_t iter_exp_variants_4096 = 2;
+    // Wider than the accelerator: Karatsuba over hardware plain multiplies
+    const size_t iter_mult_big = 10;
+    const size_t iter_exp_small_big = 5;
+    const size_t iter_exp_full_big = 2;
+
+    benchmark_suite_fixed_mod(2048, iter_mult_2048, iter_exp_small_2048, iter_exp_full_2048, iter_exp_variants_2048);
+    report_model_counters(2048);
+    benchmark_suite_fixed_mod(4096, iter_mult_4096, iter_exp_small_4096, iter_exp_full_4096, iter_exp_variants_4096);
+    report_model_counters(4096);
+    benchmark_suite_fixed_mod(6144, iter_mult_big, iter_exp_small_big, iter_exp_full_big, 0);
+    report_model_counters(6144);
+    benchmark_suite_fixed_mod(8192, iter_mult_big, iter_exp_small_big, iter_exp_full_big, 0);
+    report_model_counters(8192);
 
-    benchmark_suite_fixed_mod(2048, iter_mult_2048, iter_exp_small_2048, iter_exp_full_2048);
-    benchmark_suite_fixed_mod(4096, iter_mult_4096, iter_exp_small_4096, iter_exp_full_4096);
+    // Context path vs stock mbedtls (and its software routine) at every
+    // accelerator width
+    const size_t iter_engine_mult = 20;
+    const size_t iter_engine_exp = 3;
+    for (size_t i = 0; i < sizeof(check_bits) / sizeof(check_bits[0]); i++) {
+        benchmark_engines(check_bits[i], iter_engine_mult, iter_engine_exp);
+    }
 
+    // Scaling curve over every 256-bit size the accelerator covers
+    benchmark_size_sweep(iter_mult_2048, iter_exp_small_2048);
+
+#if !CONFIG_IDF_TARGET_LINUX
     printf("\n══════════════════════════════════════════\n");
     printf("Stage 5: SHA Benchmarks\n");
     printf("══════════════════════════════════════════\n");
 
     benchmark_sha256_lengths(100);
+    benchmark_sha256_batch(20);
     benchmark_full_domain_hash(2048, 50);
     benchmark_full_domain_hash(4096, 50);
+#endif
     
     printf("\n══════════════════════════════════════════\n");
     printf("Benchmark Complete!\n");
     printf("══════════════════════════════════════════\n\n");
+
+#if CONFIG_IDF_TARGET_LINUX
+    // A host run ends here rather than idling like the device
+    exit(0);
+#endif
     
     while (1) {
         vTaskDelay(5000 / portTICK_PERIOD_MS);
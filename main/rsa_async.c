@@ -0,0 +1,344 @@
+#include "rsa_async.h"
+
+#include <string.h>
+
+#include "esp_timer.h"
+#include "rsa_hal.h"
+
+// Operand sources beyond the scratch registers
+#define SRC_X   0xF0
+#define SRC_Y   0xF1
+#define SRC_RR  0xF2
+#define SRC_ONE 0xF3
+#define DST_OUT 0xFF
+
+enum {
+    PHASE_TO_MONT,
+    PHASE_MULT,
+    PHASE_CHAIN,
+    PHASE_TABLE_SQR,
+    PHASE_TABLE,
+    PHASE_STEPS,
+    PHASE_TAIL,
+    PHASE_FROM_MONT,
+    PHASE_DONE,
+};
+
+static intr_handle_t s_intr;
+static rsa_async_t *volatile s_active;
+// Guards the s_active handoff and every engine access made by the ISR, so a
+// timed-out wait on one core cannot release the engine under an ISR that is
+// still running on the other.
+static portMUX_TYPE s_async_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const uint32_t *async_src(const rsa_async_t *op, uint8_t src, size_t *n) {
+    const rsa_mont_ctx_t *ctx = op->ctx;
+    switch (src) {
+    case SRC_X:
+        *n = ctx->words;
+        return op->X;
+    case SRC_Y:
+        *n = ctx->words;
+        return op->Y;
+    case SRC_RR:
+        *n = ctx->Rinv.MBEDTLS_PRIVATE(n);
+        return ctx->Rinv.MBEDTLS_PRIVATE(p);
+    case SRC_ONE:
+        *n = ctx->one.MBEDTLS_PRIVATE(n);
+        return ctx->one.MBEDTLS_PRIVATE(p);
+    default:
+        *n = ctx->hw_words;
+        return ctx->scratch[src].MBEDTLS_PRIVATE(p);
+    }
+}
+
+static void async_issue(rsa_async_t *op, uint8_t dst, uint8_t a, uint8_t b) {
+    size_t n;
+    const uint32_t *p = async_src(op, a, &n);
+    mpi_hal_write_to_mem_block(MPI_PARAM_X, 0, p, n, op->ctx->hw_words);
+    p = async_src(op, b, &n);
+    mpi_hal_write_to_mem_block(MPI_PARAM_Z, 0, p, n, op->ctx->hw_words);
+    op->dst = dst;
+    op->montmuls++;
+    mpi_hal_start_op(MPI_MULT);
+}
+
+// Starts the montmul after the one just collected. Returns false once the
+// sequence is finished. Mirrors exp_body_locked, except that the running
+// value moves into the accumulator with its first squaring instead of a copy.
+static bool async_issue_next(rsa_async_t *op) {
+    const rsa_exp_plan_t *plan = op->plan;
+    const uint8_t x2 = (uint8_t)op->ctx->scratch_regs;
+    const uint8_t acc = x2 + 1;
+
+    for (;;) {
+        switch (op->phase) {
+        case PHASE_TO_MONT:
+            if (!plan) {
+                op->phase = PHASE_MULT;
+            } else if (plan->is_chain) {
+                op->phase = PHASE_CHAIN;
+            } else {
+                op->phase = (plan->table_size > 1) ? PHASE_TABLE_SQR : PHASE_STEPS;
+                op->cur = plan->steps[0].digit >> 1;
+            }
+            op->index = (plan && !plan->is_chain) ? 1 : 0;
+            op->count = 0;
+            async_issue(op, 0, SRC_X, SRC_RR);
+            return true;
+
+        case PHASE_MULT:
+            op->phase = PHASE_DONE;
+            async_issue(op, DST_OUT, 0, SRC_Y);
+            return true;
+
+        case PHASE_CHAIN:
+            if (op->index < plan->op_count) {
+                const rsa_exp_op_t *o = &plan->ops[op->index++];
+                async_issue(op, o->dst, o->a, o->b);
+                return true;
+            }
+            op->cur = (plan->op_count > 0) ? plan->result_reg : 0;
+            op->phase = PHASE_FROM_MONT;
+            break;
+
+        case PHASE_TABLE_SQR:
+            op->phase = PHASE_TABLE;
+            op->count = 1;
+            async_issue(op, x2, 0, 0);
+            return true;
+
+        case PHASE_TABLE:
+            if (op->count < plan->table_size) {
+                uint8_t k = (uint8_t)op->count++;
+                async_issue(op, k, k - 1, x2);
+                return true;
+            }
+            op->phase = PHASE_STEPS;
+            op->count = 0;
+            break;
+
+        case PHASE_STEPS:
+            if (op->index < plan->step_count) {
+                const rsa_exp_step_t *step = &plan->steps[op->index];
+                uint8_t cur = op->cur;
+                op->cur = acc;
+                if (op->count < step->squarings) {
+                    op->count++;
+                    async_issue(op, acc, cur, cur);
+                } else {
+                    op->index++;
+                    op->count = 0;
+                    async_issue(op, acc, cur, step->digit >> 1);
+                }
+                return true;
+            }
+            op->phase = PHASE_TAIL;
+            op->count = 0;
+            break;
+
+        case PHASE_TAIL:
+            if (op->count < plan->tail_squarings) {
+                uint8_t cur = op->cur;
+                op->cur = acc;
+                op->count++;
+                async_issue(op, acc, cur, cur);
+                return true;
+            }
+            op->phase = PHASE_FROM_MONT;
+            break;
+
+        case PHASE_FROM_MONT:
+            op->phase = PHASE_DONE;
+            async_issue(op, DST_OUT, op->cur, SRC_ONE);
+            return true;
+
+        default:
+            return false;
+        }
+    }
+}
+
+// Reads the Z block into the op's destination with the same final
+// subtraction esp_mont_hw_op applies. That includes the output: the
+// from-Montgomery step of an exponentiation is already below M, but the
+// single montmul of rsa_async_mult_start is only below 2M, which can need
+// one bit more than ctx->words words. The output is therefore reduced in
+// scratch register 0 (free by then) at full hw_words width and copied out.
+static void async_collect(rsa_async_t *op) {
+    const rsa_mont_ctx_t *ctx = op->ctx;
+    uint8_t reg = (op->dst == DST_OUT) ? 0 : op->dst;
+    uint32_t *r = ctx->scratch[reg].MBEDTLS_PRIVATE(p);
+    for (size_t i = 0; i < ctx->hw_words; i++) {
+        r[i] = DPORT_REG_READ(RSA_MEM_Z_BLOCK_BASE + i * 4);
+    }
+
+    const uint32_t *m = ctx->M.MBEDTLS_PRIVATE(p);
+    size_t m_words = ctx->M.MBEDTLS_PRIVATE(n);
+    int cmp = 0;
+    for (size_t i = ctx->hw_words; i-- > 0 && cmp == 0;) {
+        uint32_t mi = (i < m_words) ? m[i] : 0;
+        cmp = (r[i] > mi) - (r[i] < mi);
+    }
+    if (cmp >= 0) {
+        uint32_t borrow = 0;
+        for (size_t i = 0; i < ctx->hw_words; i++) {
+            uint64_t d = (uint64_t)r[i] - ((i < m_words) ? m[i] : 0) - borrow;
+            r[i] = (uint32_t)d;
+            borrow = (uint32_t)(d >> 63);
+        }
+    }
+
+    if (op->dst == DST_OUT) {
+        memcpy(op->Z, r, ctx->words * sizeof(uint32_t));
+    }
+}
+
+// Runs outside the lock once the engine is no longer needed. done is set
+// last, after the callback, so a waiter that sees it may free op at once.
+static void async_complete(rsa_async_t *op, BaseType_t *woken) {
+    TaskHandle_t waiter = op->waiter;
+    if (op->cb) {
+        op->cb(op, true, op->cb_arg);
+    }
+    op->done = true;
+    vTaskNotifyGiveFromISR(waiter, woken);
+}
+
+static void rsa_async_isr(void *arg) {
+    (void)arg;
+    portENTER_CRITICAL_ISR(&s_async_lock);
+    rsa_async_t *op = s_active;
+    if (!op) {
+        // Detached by a timed-out wait; the engine may already belong to
+        // someone else, so leave it alone
+        portEXIT_CRITICAL_ISR(&s_async_lock);
+        return;
+    }
+    mpi_hal_clear_interrupt();
+    async_collect(op);
+    bool more = async_issue_next(op);
+    if (!more) {
+        s_active = NULL;
+        op->ok = true;
+    }
+    portEXIT_CRITICAL_ISR(&s_async_lock);
+    if (more) {
+        return;
+    }
+
+    BaseType_t woken = pdFALSE;
+    async_complete(op, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static bool async_start(rsa_async_t *op, const rsa_mont_ctx_t *ctx,
+                        const uint32_t *X, const uint32_t *Y, const rsa_exp_plan_t *plan,
+                        uint32_t *Z, rsa_async_cb_t cb, void *arg) {
+    // Flags 0: the handler is not IRAM-safe, see rsa_async.h
+    if (!s_intr && esp_intr_alloc(ETS_RSA_INTR_SOURCE, 0, rsa_async_isr, NULL, &s_intr) != ESP_OK) {
+        return false;
+    }
+
+    memset(op, 0, sizeof(*op));
+    op->ctx = ctx;
+    op->plan = plan;
+    op->X = X;
+    op->Y = Y;
+    op->Z = Z;
+    op->phase = PHASE_TO_MONT;
+    op->cb = cb;
+    op->cb_arg = arg;
+    op->waiter = xTaskGetCurrentTaskHandle();
+
+    // Blocks here while another task holds the peripheral
+    esp_mpi_enable_hardware_hw_op();
+    op->locked = true;
+    mpi_hal_write_to_mem_block(MPI_PARAM_M, 0, ctx->M.MBEDTLS_PRIVATE(p), ctx->M.MBEDTLS_PRIVATE(n), ctx->hw_words);
+    mpi_hal_write_m_prime(ctx->mprime);
+    mpi_hal_set_mode((ctx->hw_words / 16) - 1);
+    mpi_hal_clear_interrupt();
+    mpi_hal_interrupt_enable(true);
+
+    portENTER_CRITICAL(&s_async_lock);
+    s_active = op;
+    async_issue_next(op);
+    portEXIT_CRITICAL(&s_async_lock);
+    return true;
+}
+
+bool rsa_async_mult_start(rsa_async_t *op, const rsa_mont_ctx_t *ctx,
+                          const uint32_t *X, const uint32_t *Y, uint32_t *Z,
+                          rsa_async_cb_t cb, void *arg) {
+    if (!op || !ctx || !X || !Y || !Z) {
+        return false;
+    }
+    return async_start(op, ctx, X, Y, NULL, Z, cb, arg);
+}
+
+bool rsa_async_exp_start(rsa_async_t *op, const rsa_mont_ctx_t *ctx,
+                         const uint32_t *X, const rsa_exp_plan_t *plan, uint32_t *Z,
+                         rsa_async_cb_t cb, void *arg) {
+    if (!op || !ctx || !X || !plan || !Z) {
+        return false;
+    }
+    // The ISR cannot allocate, so the plan must fit the context's arena
+    if (!plan->is_chain && plan->table_size > ctx->scratch_regs) {
+        return false;
+    }
+
+    if (!plan->is_chain && plan->step_count == 0) {
+        memset(op, 0, sizeof(*op));
+        memset(Z, 0, ctx->words * 4);
+        Z[0] = 1;
+        op->ctx = ctx;
+        op->ok = true;
+        op->done = true;
+        if (cb) {
+            cb(op, true, arg);
+        }
+        return true;
+    }
+    return async_start(op, ctx, X, NULL, plan, Z, cb, arg);
+}
+
+bool rsa_async_done(const rsa_async_t *op) {
+    return op->done;
+}
+
+bool rsa_async_wait(rsa_async_t *op, uint32_t timeout_ms) {
+    if (!op) {
+        return false;
+    }
+
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    while (!op->done) {
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms)) == 0 &&
+            esp_timer_get_time() >= deadline) {
+            break;
+        }
+    }
+
+    if (op->locked) {
+        portENTER_CRITICAL(&s_async_lock);
+        bool detached = (s_active == op);
+        if (detached) {
+            // Timed out: no ISR can touch the engine for op after this
+            s_active = NULL;
+            op->ok = false;
+        }
+        mpi_hal_interrupt_enable(false);
+        portEXIT_CRITICAL(&s_async_lock);
+        if (!detached) {
+            // The ISR finished the last montmul but may still be running
+            // the callback on the other core
+            while (!op->done) {
+            }
+        }
+        esp_mpi_disable_hardware_hw_op();
+        op->locked = false;
+    }
+    return op->done && op->ok;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "rsa_hw.h"
+
+// Interrupt-driven modmult/modexp. Start queues the first montmul and
+// returns; the RSA completion interrupt reads each result, writes the next
+// operands and restarts the engine, so the whole chain runs without the CPU
+// polling. Operands use the zero-copy word layout (ctx->words little-endian
+// words), and intermediates live in the context's scratch arena.
+//
+// Start takes the peripheral lock and rsa_async_wait releases it, so wait
+// must be called by the task that started the op, even when a callback is
+// used.
+//
+// The callback runs in interrupt context, possibly on the other core: it
+// must not block, and may only use FromISR FreeRTOS calls. The handler is
+// allocated without ESP_INTR_FLAG_IRAM because it calls HAL and mbedtls
+// code that lives in flash, so it is deferred while the flash cache is
+// disabled (e.g. during SPI flash writes) and the callback need not be in
+// IRAM either.
+typedef struct rsa_async rsa_async_t;
+typedef void (*rsa_async_cb_t)(rsa_async_t *op, bool ok, void *arg);
+
+struct rsa_async {
+    const rsa_mont_ctx_t *ctx;
+    const rsa_exp_plan_t *plan;
+    const uint32_t *X;
+    const uint32_t *Y;
+    uint32_t *Z;
+    // Position in the montmul sequence, advanced by the ISR
+    uint8_t phase;
+    size_t index;
+    size_t count;
+    uint8_t cur;
+    uint8_t dst;
+    size_t montmuls;
+    rsa_async_cb_t cb;
+    void *cb_arg;
+    TaskHandle_t waiter;
+    volatile bool done;
+    bool ok;
+    bool locked;
+};
+
+bool rsa_async_mult_start(rsa_async_t *op, const rsa_mont_ctx_t *ctx,
+                          const uint32_t *X, const uint32_t *Y, uint32_t *Z,
+                          rsa_async_cb_t cb, void *arg);
+bool rsa_async_exp_start(rsa_async_t *op, const rsa_mont_ctx_t *ctx,
+                         const uint32_t *X, const rsa_exp_plan_t *plan, uint32_t *Z,
+                         rsa_async_cb_t cb, void *arg);
+bool rsa_async_done(const rsa_async_t *op);
+// Blocks on a task notification until the op completes, then releases the
+// peripheral. Returns false on failure or timeout.
+bool rsa_async_wait(rsa_async_t *op, uint32_t timeout_ms);
@@ -1,52 +1,60 @@
 #include "rsa_hw.h"
+#include "rsa_async.h"
+#include "rsa_pipeline.h"
+#include "rsa_big.h"
+#include "rsa_ctx_cache.h"
+#include "bench_timer.h"
+#include "bench_stats.h"
+#include "bench_log.h"
 #include <stdio.h>
 #include <inttypes.h>
 #include <string.h>
-#include <math.h>
 #include "esp_timer.h"
 #include "esp_heap_caps.h"
 #include "esp_system.h"
 #include "esp_random.h"
+#include "freertos/FreeRTOS.h"
+#include "rsa_hal.h"
 
 #define RSA_2048_BITS 2048
 #define RSA_2048_WORDS (RSA_2048_BITS / 32)
 
 // ==================== BENCHMARK FUNCTIONS ====================
 
-typedef struct {
-    uint64_t min_us;
-    uint64_t max_us;
-    uint64_t total_us;
-    double sumsq;
-    size_t count;
-} bench_stats_t;
-
-static void stats_init(bench_stats_t *s) {
-    s->min_us = UINT64_MAX;
-    s->max_us = 0;
-    s->total_us = 0;
-    s->sumsq = 0.0;
-    s->count = 0;
+// Accelerator work (rsa_hw.c's counters) of the calls bracketed by
+// ops_begin/ops_end since the last ops_reset, printed per call as CSV_OPS.
+// Each measured loop resets first, so a benchmark that breaks out before
+// its summary cannot leak counts into the next op's row.
+static rsa_hw_op_counts_t s_ops_acc;
+static rsa_hw_op_counts_t s_ops_mark;
+static size_t s_ops_calls;
+
+static void ops_reset(void) {
+    memset(&s_ops_acc, 0, sizeof(s_ops_acc));
+    s_ops_calls = 0;
 }
 
-static void stats_update(bench_stats_t *s, uint64_t us) {
-    if (us < s->min_us) s->min_us = us;
-    if (us > s->max_us) s->max_us = us;
-    s->total_us += us;
-    s->sumsq += (double)us * (double)us;
-    s->count++;
+static void ops_begin(void) {
+    rsa_hw_op_counts_get(&s_ops_mark);
 }
 
-static double stats_avg_us(const bench_stats_t *s) {
-    if (s->count == 0) return 0.0;
-    return (double)s->total_us / (double)s->count;
+static void ops_end(void) {
+    rsa_hw_op_counts_t now;
+    rsa_hw_op_counts_get(&now);
+    rsa_hw_op_counts_sub(&s_ops_acc, &now, &s_ops_mark);
+    s_ops_calls++;
 }
 
-static double stats_stddev_us(const bench_stats_t *s) {
-    if (s->count == 0) return 0.0;
-    double mean = stats_avg_us(s);
-    double var = (s->sumsq / (double)s->count) - (mean * mean);
-    return (var > 0.0) ? sqrt(var) : 0.0;
+static void csv_ops(const char *op, size_t bits, const char *exp_label) {
+    if (!RSA_HW_OP_COUNTERS || s_ops_calls == 0) {
+        return;
+    }
+    const rsa_hw_op_counts_t *c = &s_ops_acc;
+    double n = (double)s_ops_calls;
+    printf("CSV_OPS,%s,%zu,%s,%zu,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n", op, bits, exp_label, s_ops_calls,
+           c->montmuls / n, c->squarings / n, c->enables / n, c->disables / n, c->operand_loads / n,
+           c->modulus_loads / n, c->result_reads / n, c->bytes_copied / n);
+    ops_reset();
 }
 
 static void csv_iter(const char *op, size_t bits, const char *exp_label, size_t iter, uint64_t us) {
@@ -55,10 +63,42 @@ static void csv_iter(const char *op, size_t bits, const char *exp_label, size_t
 
 static void csv_summary(const char *op, size_t bits, const char *exp_label,
                         size_t iterations, size_t success, const bench_stats_t *s) {
-    double avg = stats_avg_us(s);
-    double stddev = stats_stddev_us(s);
+    // Per-iteration rows recorded during the run go out ahead of their summary
+    bench_log_flush();
+    double avg = bench_stats_avg(s);
+    double stddev = bench_stats_stddev(s);
     printf("CSV_SUMMARY,%s,%zu,%s,%zu,%zu,%.2f,%" PRIu64 ",%" PRIu64 ",%.2f\n",
-           op, bits, exp_label, iterations, success, avg, s->min_us, s->max_us, stddev);
+           op, bits, exp_label, iterations, success, avg, s->min, s->max, stddev);
+    bench_stats_csv_hist(op, bits, exp_label, "us", s);
+    csv_ops(op, bits, exp_label);
+}
+
+// Heap calls made inside the timed region; zero once the context owns all
+// of its scratch and the output mpi has been sized by the warm-up.
+static void csv_heap(const char *op, size_t bits, const char *exp_label,
+                     size_t successful, size_t heap_calls) {
+    printf("CSV_HEAP,%s,%zu,%s,%zu,%zu,%.2f\n", op, bits, exp_label, successful, heap_calls,
+           successful ? (double)heap_calls / (double)successful : 0.0);
+}
+
+// Scaling-curve row: one per op and size, from the native context up to
+// 4096 bits and the Karatsuba layer above. hw_ops counts montmuls on the
+// native path and plain multiplies on the Karatsuba path.
+static void csv_scale(size_t bits, const char *engine, const char *op, const char *exp_label,
+                      double avg_us, double hw_ops) {
+    printf("CSV_SCALE,%zu,%s,%s,%s,%.2f,%.1f\n", bits, engine, op, exp_label, avg_us, hw_ops);
+}
+
+// Cycle-resolution companion to csv_summary, filled from bench_timer. The
+// stats hold cycles rather than µs; the CSV_CYC rows come from bench_log.
+static void csv_cyc_summary(const char *op, size_t bits, const char *exp_label,
+                            size_t success, const bench_stats_t *cycles) {
+    double avg = bench_stats_avg(cycles);
+    uint32_t mhz = bench_timer_cpu_mhz();
+    printf("CSV_CYC_SUMMARY,%s,%zu,%s,%s,%zu,%.1f,%" PRIu64 ",%" PRIu64 ",%.1f\n",
+           op, bits, exp_label, bench_timer_source_name(), success, avg, cycles->min, cycles->max,
+           mhz ? avg * 1000.0 / (double)mhz : 0.0);
+    bench_stats_csv_hist(op, bits, exp_label, "cycles", cycles);
 }
 
 static void fill_random_words(uint32_t *num, size_t words) {
@@ -68,26 +108,34 @@ static void fill_random_words(uint32_t *num, size_t words) {
     }
 }
 
+// Sizes need not be a multiple of 32: the top word keeps only the bits
+// below bit `bits`, and bit bits-1 is the MSB
+static void trim_top_word(uint32_t *num, size_t bits) {
+    if (bits % 32 != 0) {
+        num[(bits - 1) / 32] &= (1u << (bits % 32)) - 1u;
+    }
+}
+
 static void set_msb(uint32_t *num, size_t bits) {
-    size_t last = (bits / 32) - 1;
-    num[last] |= 0x80000000u;
+    num[(bits - 1) / 32] |= 1u << ((bits - 1) % 32);
 }
 
 static void clear_msb(uint32_t *num, size_t bits) {
-    size_t last = (bits / 32) - 1;
-    num[last] &= 0x7FFFFFFFu;
+    num[(bits - 1) / 32] &= ~(1u << ((bits - 1) % 32));
 }
 
 static void generate_modulus(uint32_t *M, size_t bits) {
-    size_t words = bits / 32;
+    size_t words = (bits + 31) / 32;
     fill_random_words(M, words);
+    trim_top_word(M, bits);
     set_msb(M, bits);
     M[0] |= 0x01u; // ensure odd
 }
 
 static void generate_operand(uint32_t *X, size_t bits) {
-    size_t words = bits / 32;
+    size_t words = (bits + 31) / 32;
     fill_random_words(X, words);
+    trim_top_word(X, bits);
     clear_msb(X, bits); // ensure < modulus with MSB set
 }
 
@@ -150,8 +198,9 @@ static void set_small_exponent(uint32_t *E, size_t words, uint32_t exp) {
 }
 
 static void set_full_exponent(uint32_t *E, size_t bits) {
-    size_t words = bits / 32;
+    size_t words = (bits + 31) / 32;
     fill_random_words(E, words);
+    trim_top_word(E, bits);
     set_msb(E, bits);
 }
 
@@ -187,27 +236,36 @@ static void benchmark_modmult_ctx(const rsa_mont_ctx_t *ctx, size_t bits, size_t
         (void)rsa_mod_mult_hw_ctx(ctx, &X_mpi, &Y_mpi, &Z_mpi);
     }
 
-    bench_stats_t stats;
-    stats_init(&stats);
+    bench_stats_t stats, cycle_stats;
+    bench_stats_init(&stats);
+    bench_stats_init(&cycle_stats);
     size_t successful_ops = 0;
+    size_t heap_calls = 0;
 
     printf("\nStarting benchmark...\n");
 
+    ops_reset();
     for (size_t i = 0; i < iterations; i++) {
         generate_operand(X, bits);
         generate_operand(Y, bits);
         rsa_mpi_set_words(&X_mpi, X, words);
         rsa_mpi_set_words(&Y_mpi, Y, words);
 
-        uint64_t start = esp_timer_get_time();
+        size_t heap_before = rsa_heap_calls();
+        bench_timer_t timer;
+        bench_sample_t sample;
+        ops_begin();
+        bench_timer_start(&timer);
         bool success = rsa_mod_mult_hw_ctx(ctx, &X_mpi, &Y_mpi, &Z_mpi);
-        uint64_t end = esp_timer_get_time();
+        bench_timer_stop(&timer, &sample);
+        ops_end();
+        heap_calls += rsa_heap_calls() - heap_before;
 
         if (success) {
-            uint64_t us = end - start;
-            stats_update(&stats, us);
+            bench_stats_update(&stats, sample.us);
+            bench_stats_update(&cycle_stats, sample.cycles);
             successful_ops++;
-            csv_iter("modmult", bits, "na", i + 1, us);
+            bench_log_record("modmult", bits, "na", i + 1, sample.us, &sample);
 
             if (iterations >= 5 && (i + 1) % (iterations / 5) == 0) {
                 printf("  Progress: %zu/%zu\n", i + 1, iterations);
@@ -219,16 +277,16 @@ static void benchmark_modmult_ctx(const rsa_mont_ctx_t *ctx, size_t bits, size_t
     }
 
     if (successful_ops > 0) {
-        double avg_us = stats_avg_us(&stats);
-        double stddev_us = stats_stddev_us(&stats);
+        double avg_us = bench_stats_avg(&stats);
+        double stddev_us = bench_stats_stddev(&stats);
         printf("\nBenchmark Results:\n");
         printf("  Successful operations: %zu/%zu\n", successful_ops, iterations);
-        printf("  Total time: %" PRIu64 " µs\n", stats.total_us);
+        printf("  Total time: %" PRIu64 " µs\n", stats.total);
         printf("  Average time: %.2f µs\n", avg_us);
         printf("  Average time: %.2f ms\n", avg_us / 1000.0);
         printf("  Stddev: %.2f µs\n", stddev_us);
-        printf("  Min: %" PRIu64 " µs\n", stats.min_us);
-        printf("  Max: %" PRIu64 " µs\n", stats.max_us);
+        printf("  Min: %" PRIu64 " µs\n", stats.min);
+        printf("  Max: %" PRIu64 " µs\n", stats.max);
 
         rsa_mpi_get_words(&Z_mpi, Z, words);
         bool any_nonzero = false;
@@ -241,6 +299,9 @@ static void benchmark_modmult_ctx(const rsa_mont_ctx_t *ctx, size_t bits, size_t
         printf("  Result is %s\n", any_nonzero ? "non-zero ✓" : "zero ⚠");
 
         csv_summary("modmult", bits, "na", iterations, successful_ops, &stats);
+        csv_cyc_summary("modmult", bits, "na", successful_ops, &cycle_stats);
+        csv_scale(bits, "native", "modmult", "na", avg_us, 2.0);
+        csv_heap("modmult", bits, "na", successful_ops, heap_calls);
     } else {
         printf("\nNo successful operations!\n");
     }
@@ -254,157 +315,2019 @@ static void benchmark_modmult_ctx(const rsa_mont_ctx_t *ctx, size_t bits, size_t
     heap_caps_free(Z);
 }
 
-static void benchmark_modexp_ctx(const rsa_mont_ctx_t *ctx, size_t bits, size_t iterations,
-                                 const uint32_t *E_words, const char *exp_label, bool feed_wdt) {
+// Same modmult loop twice: printing each CSV row between iterations, as the
+// loops used to, and recording into bench_log for a flush afterwards. At
+// 115200 baud a row takes milliseconds to drain, so the inline run measures
+// UART interrupts and cache refills alongside the multiply.
+static void benchmark_log_jitter_ctx(const rsa_mont_ctx_t *ctx, size_t bits, size_t iterations) {
     size_t words = bits / 32;
 
     uint32_t *X = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *Y = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
     uint32_t *Z = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    if (!X || !Y || !Z) {
+        printf("Memory allocation failed\n");
+        heap_caps_free(X);
+        heap_caps_free(Y);
+        heap_caps_free(Z);
+        return;
+    }
 
-    if (!X || !Z) {
+    printf("\n══════════════════════════════════════════\n");
+    printf("Sample Log Jitter (%zu-bit modmult, inline printf vs deferred log)\n", bits);
+    printf("Iterations: %zu\n", iterations);
+    printf("══════════════════════════════════════════\n");
+
+    static const char *const mode_names[2] = {"inline", "deferred"};
+    double stddev[2] = {0.0, 0.0};
+    double spread[2] = {0.0, 0.0};
+    bench_stats_t cycles;
+    for (size_t mode = 0; mode < 2; mode++) {
+        bench_stats_init(&cycles);
+        size_t successful_ops = 0;
+        uint64_t wall_start = esp_timer_get_time();
+        for (size_t i = 0; i < iterations; i++) {
+            generate_operand(X, bits);
+            generate_operand(Y, bits);
+
+            bench_timer_t timer;
+            bench_sample_t sample;
+            bench_timer_start(&timer);
+            bool success = rsa_mod_mult_hw_words(ctx, X, Y, Z);
+            bench_timer_stop(&timer, &sample);
+            if (!success) {
+                printf("  Failed at iteration %zu\n", i);
+                break;
+            }
+            bench_stats_update(&cycles, sample.cycles);
+            successful_ops++;
+            if (mode == 0) {
+                csv_iter("modmult_jitter", bits, mode_names[mode], i + 1, sample.us);
+            } else {
+                bench_log_record("modmult_jitter", bits, mode_names[mode], i + 1, sample.us, NULL);
+            }
+        }
+        bench_log_flush();
+        uint64_t wall_us = esp_timer_get_time() - wall_start;
+
+        if (successful_ops == 0) {
+            printf("\nNo successful operations!\n");
+            break;
+        }
+        double p50 = bench_stats_quantile(&cycles, 0.50);
+        double p99 = bench_stats_quantile(&cycles, 0.99);
+        stddev[mode] = bench_stats_stddev(&cycles);
+        spread[mode] = p99 - p50;
+        printf("  %s: avg %.1f cycles, stddev %.1f, p99-p50 %.1f, loop+flush %" PRIu64 " µs\n",
+               mode_names[mode], bench_stats_avg(&cycles), stddev[mode], spread[mode], wall_us);
+        printf("CSV_JITTER,%zu,%s,%zu,%.1f,%.1f,%.1f,%.1f,%" PRIu64 "\n", bits, mode_names[mode],
+               successful_ops, bench_stats_avg(&cycles), stddev[mode], p50, p99, wall_us);
+    }
+    if (stddev[1] > 0.0) {
+        printf("  Deferred log: stddev %.2fx lower, p99-p50 %.2fx lower\n",
+               stddev[0] / stddev[1], spread[1] > 0.0 ? spread[0] / spread[1] : 0.0);
+    }
+
+    heap_caps_free(X);
+    heap_caps_free(Y);
+    heap_caps_free(Z);
+}
+
+static void benchmark_modmult_chain_ctx(const rsa_mont_ctx_t *ctx, size_t bits, size_t iterations,
+                                        size_t chain_len) {
+    size_t words = bits / 32;
+
+    uint32_t *X = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *Y = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *Z = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+
+    if (!X || !Y || !Z || chain_len == 0) {
         printf("Memory allocation failed\n");
+        heap_caps_free(X);
+        heap_caps_free(Y);
+        heap_caps_free(Z);
         return;
     }
 
-    mbedtls_mpi X_mpi, E_mpi, Z_mpi;
+    mbedtls_mpi X_mpi, Y_mpi, Z_mpi;
     mbedtls_mpi_init(&X_mpi);
-    mbedtls_mpi_init(&E_mpi);
+    mbedtls_mpi_init(&Y_mpi);
     mbedtls_mpi_init(&Z_mpi);
 
-    rsa_mpi_set_words(&E_mpi, E_words, words);
+    rsa_mont_elem_t acc, y;
+    rsa_mont_elem_init(&acc);
+    rsa_mont_elem_init(&y);
+
+    char label[16];
+    snprintf(label, sizeof(label), "len%zu", chain_len);
 
     const size_t warmup = 1;
     printf("\n══════════════════════════════════════════\n");
-    printf("Modular Exponentiation Benchmark (%zu-bit, %s exponent, fixed modulus)\n", bits, exp_label);
+    printf("Chained Modular Multiplication Benchmark (%zu-bit, Montgomery domain)\n", bits);
     printf("Iterations: %zu\n", iterations);
+    printf("Chain length: %zu multiplies (conversions amortized)\n", chain_len);
     printf("Warm-up iterations: %zu\n", warmup);
     printf("══════════════════════════════════════════\n");
 
-    for (size_t i = 0; i < warmup; i++) {
-        generate_operand(X, bits);
-        rsa_mpi_set_words(&X_mpi, X, words);
-        (void)rsa_mod_exp_hw_ctx(ctx, &X_mpi, &E_mpi, &Z_mpi, feed_wdt);
-    }
-
     bench_stats_t stats;
-    stats_init(&stats);
+    bench_stats_init(&stats);
     size_t successful_ops = 0;
 
     printf("\nStarting benchmark...\n");
 
-    for (size_t i = 0; i < iterations; i++) {
+    ops_reset();
+    for (size_t i = 0; i < warmup + iterations; i++) {
         generate_operand(X, bits);
+        generate_operand(Y, bits);
         rsa_mpi_set_words(&X_mpi, X, words);
+        rsa_mpi_set_words(&Y_mpi, Y, words);
 
+        // One conversion in per operand, chain_len multiplies, one conversion out
+        ops_begin();
         uint64_t start = esp_timer_get_time();
-        bool success = rsa_mod_exp_hw_ctx(ctx, &X_mpi, &E_mpi, &Z_mpi, feed_wdt);
+        bool success = rsa_mont_to_mont(ctx, &X_mpi, &acc) &&
+                       rsa_mont_to_mont(ctx, &Y_mpi, &y);
+        for (size_t k = 0; success && k < chain_len; k++) {
+            success = rsa_mont_mul(ctx, &acc, &y, &acc);
+        }
+        success = success && rsa_mont_from_mont(ctx, &acc, &Z_mpi);
         uint64_t end = esp_timer_get_time();
+        ops_end();
 
+        if (i < warmup) {
+            continue;
+        }
         if (success) {
             uint64_t us = end - start;
-            stats_update(&stats, us);
+            bench_stats_update(&stats, us);
             successful_ops++;
-            csv_iter("modexp", bits, exp_label, i + 1, us);
-
-            if (iterations >= 5 && (i + 1) % (iterations / 5) == 0) {
-                printf("  Progress: %zu/%zu\n", i + 1, iterations);
-            }
+            bench_log_record("modmult_chain", bits, label, i + 1 - warmup, us, NULL);
         } else {
-            printf("  Failed at iteration %zu\n", i);
+            printf("  Failed at iteration %zu\n", i - warmup);
             break;
         }
     }
 
     if (successful_ops > 0) {
-        double avg_us = stats_avg_us(&stats);
-        double stddev_us = stats_stddev_us(&stats);
+        double avg_us = bench_stats_avg(&stats);
         printf("\nBenchmark Results:\n");
-        printf("  Successful operations: %zu/%zu\n", successful_ops, iterations);
-        printf("  Total time: %" PRIu64 " µs\n", stats.total_us);
-        printf("  Average time: %.2f µs\n", avg_us);
-        printf("  Average time: %.2f ms\n", avg_us / 1000.0);
-        printf("  Stddev: %.2f µs\n", stddev_us);
-        printf("  Min: %" PRIu64 " µs\n", stats.min_us);
-        printf("  Max: %" PRIu64 " µs\n", stats.max_us);
+        printf("  Successful chains: %zu/%zu\n", successful_ops, iterations);
+        printf("  Average chain time: %.2f µs\n", avg_us);
+        printf("  Per multiply: %.2f µs\n", avg_us / (double)chain_len);
+        csv_summary("modmult_chain", bits, label, iterations, successful_ops, &stats);
+        printf("CSV_CHAIN_HEADER,bits,chain_len,avg_chain_us,per_mult_us\n");
+        printf("CSV_CHAIN,%zu,%zu,%.2f,%.2f\n", bits, chain_len, avg_us, avg_us / (double)chain_len);
+    } else {
+        printf("\nNo successful operations!\n");
+    }
 
-        rsa_mpi_get_words(&Z_mpi, Z, words);
-        bool any_nonzero = false;
-        for (size_t i = 0; i < words; i++) {
-            if (Z[i] != 0) {
-                any_nonzero = true;
+    rsa_mont_elem_free(&acc);
+    rsa_mont_elem_free(&y);
+    mbedtls_mpi_free(&X_mpi);
+    mbedtls_mpi_free(&Y_mpi);
+    mbedtls_mpi_free(&Z_mpi);
+
+    heap_caps_free(X);
+    heap_caps_free(Y);
+    heap_caps_free(Z);
+}
+
+static void words_to_be_bytes(const uint32_t *words, size_t n_words, uint8_t *bytes) {
+    for (size_t i = 0; i < n_words; i++) {
+        uint32_t w = words[n_words - 1 - i];
+        bytes[i * 4] = (uint8_t)(w >> 24);
+        bytes[i * 4 + 1] = (uint8_t)(w >> 16);
+        bytes[i * 4 + 2] = (uint8_t)(w >> 8);
+        bytes[i * 4 + 3] = (uint8_t)w;
+    }
+}
+
+// Buffer-to-buffer modmult cost: the mbedtls_mpi path including its operand
+// and result copies, against the zero-copy word and byte-string paths.
+static void benchmark_modmult_path_ctx(const rsa_mont_ctx_t *ctx, size_t bits, size_t iterations) {
+    static const char *const op_names[] = {"modmult_mpi_e2e", "modmult_words", "modmult_bytes"};
+    size_t words = bits / 32;
+
+    uint32_t *X = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *Y = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *Z = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint8_t *Xb = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint8_t *Yb = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint8_t *Zb = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+
+    if (!X || !Y || !Z || !Xb || !Yb || !Zb) {
+        printf("Memory allocation failed\n");
+        heap_caps_free(X);
+        heap_caps_free(Y);
+        heap_caps_free(Z);
+        heap_caps_free(Xb);
+        heap_caps_free(Yb);
+        heap_caps_free(Zb);
+        return;
+    }
+
+    mbedtls_mpi X_mpi, Y_mpi, Z_mpi;
+    mbedtls_mpi_init(&X_mpi);
+    mbedtls_mpi_init(&Y_mpi);
+    mbedtls_mpi_init(&Z_mpi);
+
+    printf("\n══════════════════════════════════════════\n");
+    printf("Modmult Operand Path Benchmark (%zu-bit, buffer to buffer)\n", bits);
+    printf("Iterations: %zu\n", iterations);
+    printf("══════════════════════════════════════════\n");
+
+    for (size_t mode = 0; mode < sizeof(op_names) / sizeof(op_names[0]); mode++) {
+        bench_stats_t stats;
+        bench_stats_init(&stats);
+        size_t successful_ops = 0;
+
+        ops_reset();
+        for (size_t i = 0; i < iterations; i++) {
+            generate_operand(X, bits);
+            generate_operand(Y, bits);
+            words_to_be_bytes(X, words, Xb);
+            words_to_be_bytes(Y, words, Yb);
+
+            bool success;
+            ops_begin();
+            uint64_t start = esp_timer_get_time();
+            if (mode == 0) {
+                success = rsa_mpi_set_words(&X_mpi, X, words) &&
+                          rsa_mpi_set_words(&Y_mpi, Y, words) &&
+                          rsa_mod_mult_hw_ctx(ctx, &X_mpi, &Y_mpi, &Z_mpi);
+                rsa_mpi_get_words(&Z_mpi, Z, words);
+            } else if (mode == 1) {
+                success = rsa_mod_mult_hw_words(ctx, X, Y, Z);
+            } else {
+                success = rsa_mod_mult_hw_bytes(ctx, Xb, Yb, Zb);
+            }
+            uint64_t end = esp_timer_get_time();
+            ops_end();
+
+            if (success) {
+                uint64_t us = end - start;
+                bench_stats_update(&stats, us);
+                successful_ops++;
+                bench_log_record(op_names[mode], bits, "na", i + 1, us, NULL);
+            } else {
+                printf("  Failed at iteration %zu\n", i);
                 break;
             }
         }
-        printf("  Result is %s\n", any_nonzero ? "non-zero ✓" : "zero ⚠");
 
-        csv_summary("modexp", bits, exp_label, iterations, successful_ops, &stats);
-    } else {
-        printf("\nNo successful operations!\n");
+        if (successful_ops > 0) {
+            printf("  %s average: %.2f µs\n", op_names[mode], bench_stats_avg(&stats));
+            csv_summary(op_names[mode], bits, "na", iterations, successful_ops, &stats);
+        }
     }
 
     mbedtls_mpi_free(&X_mpi);
-    mbedtls_mpi_free(&E_mpi);
+    mbedtls_mpi_free(&Y_mpi);
     mbedtls_mpi_free(&Z_mpi);
 
     heap_caps_free(X);
+    heap_caps_free(Y);
     heap_caps_free(Z);
+    heap_caps_free(Xb);
+    heap_caps_free(Yb);
+    heap_caps_free(Zb);
+}
+
+#define PIPELINE_RING_SLOTS 8
+
+// Modmult is short enough that task startup would dominate a run of
+// iter_mult operations, so the pipelined modmult run is this much longer.
+#define PIPELINE_MULT_SCALE 10
+
+typedef struct {
+    uint8_t *wire;
+    size_t operands;    // 2 for modmult (X, Y), 1 for modexp (X)
+} pipeline_source_t;
+
+static void be_bytes_to_words(const uint8_t *bytes, size_t n_words, uint32_t *words) {
+    for (size_t i = 0; i < n_words; i++) {
+        const uint8_t *b = bytes + (n_words - 1 - i) * 4;
+        words[i] = ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | (uint32_t)b[3];
+    }
+}
+
+// Operand preparation as a server would do it: random wire-format bytes,
+// kept below the modulus, converted to the accelerator's word layout.
+static void pipeline_produce(uint32_t *slot, const rsa_mont_ctx_t *ctx, void *arg) {
+    pipeline_source_t *src = (pipeline_source_t *)arg;
+    for (size_t k = 0; k < src->operands; k++) {
+        esp_fill_random(src->wire, ctx->words * 4);
+        src->wire[0] &= 0x7F;
+        be_bytes_to_words(src->wire, ctx->words, slot + k * ctx->words);
+    }
+}
+
+static double ops_per_s(size_t ops, uint64_t us) {
+    return us ? (double)ops * 1000000.0 / (double)us : 0.0;
 }
 
-void benchmark_suite_fixed_mod(size_t bits, size_t iter_mult, size_t iter_exp_small, size_t iter_exp_full) {
+// Sustained throughput of operand prep + hardware op run back to back on one
+// core, against the same work split across a producer and a consumer core.
+static void benchmark_pipeline_ctx(const rsa_mont_ctx_t *ctx, size_t bits, size_t count,
+                                   const uint32_t *E_words, const char *exp_label) {
     size_t words = bits / 32;
+    const char *op_name = E_words ? "modexp_pipe" : "modmult_pipe";
 
-    uint32_t *M = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
-    uint32_t *E_small = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
-    uint32_t *E_full = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint8_t *wire = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *slot = heap_caps_calloc(words * 2, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *Z = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
 
-    if (!M || !E_small || !E_full) {
+    if (!wire || !slot || !Z) {
         printf("Memory allocation failed\n");
+        heap_caps_free(wire);
+        heap_caps_free(slot);
+        heap_caps_free(Z);
         return;
     }
 
-    generate_modulus(M, bits);
+    rsa_exp_plan_t plan;
+    bool have_plan = false;
+    if (E_words) {
+        mbedtls_mpi E_mpi;
+        mbedtls_mpi_init(&E_mpi);
+        rsa_mpi_set_words(&E_mpi, E_words, words);
+        have_plan = (mbedtls_mpi_bitlen(&E_mpi) <= 32)
+                        ? rsa_exp_plan_init_chain(&plan, E_words[0])
+                        : rsa_exp_plan_init(&plan, &E_mpi, 0);
+        mbedtls_mpi_free(&E_mpi);
+        if (!have_plan) {
+            printf("Exponent recoding failed\n");
+            heap_caps_free(wire);
+            heap_caps_free(slot);
+            heap_caps_free(Z);
+            return;
+        }
+    }
 
     printf("\n══════════════════════════════════════════\n");
-    printf("Fixed Modulus Setup (%zu-bit)\n", bits);
-    printf("M: [0x%08" PRIX32 " ... 0x%08" PRIX32 "]\n", M[words - 1], M[0]);
+    printf("Pipeline Benchmark (%zu-bit, %s, %s exponent)\n", bits, op_name, exp_label);
+    printf("Operations: %zu, ring slots: %d\n", count, PIPELINE_RING_SLOTS);
     printf("══════════════════════════════════════════\n");
 
-    rsa_mont_ctx_t ctx;
-    if (!rsa_mont_ctx_init(&ctx, M, words)) {
-        printf("Failed to initialize Montgomery context\n");
-        heap_caps_free(M);
-        heap_caps_free(E_small);
-        heap_caps_free(E_full);
+    pipeline_source_t source = {.wire = wire, .operands = E_words ? 1 : 2};
+
+    bool ok = true;
+    uint64_t start = esp_timer_get_time();
+    for (size_t i = 0; i < count && ok; i++) {
+        pipeline_produce(slot, ctx, &source);
+        ok = have_plan ? rsa_mod_exp_hw_words(ctx, slot, &plan, Z, false)
+                       : rsa_mod_mult_hw_words(ctx, slot, slot + words, Z);
+    }
+    uint64_t serial_us = esp_timer_get_time() - start;
+
+    rsa_pipeline_cfg_t cfg = {
+        .ctx = ctx,
+        .plan = have_plan ? &plan : NULL,
+        .count = count,
+        .ring_capacity = PIPELINE_RING_SLOTS,
+        .produce = pipeline_produce,
+        .sink = NULL,
+        .arg = &source,
+        .producer_core = 0,
+        .consumer_core = (portNUM_PROCESSORS > 1) ? 1 : 0,
+    };
+    rsa_pipeline_result_t result;
+    ok = ok && rsa_pipeline_run(&cfg, &result);
+
+    if (ok) {
+        double serial_rate = ops_per_s(count, serial_us);
+        double pipe_rate = ops_per_s(result.completed, result.elapsed_us);
+        printf("  Serial: %.1f ops/s\n", serial_rate);
+        printf("  Pipelined: %.1f ops/s (producer stalls %zu, consumer stalls %zu)\n",
+               pipe_rate, result.producer_stalls, result.consumer_stalls);
+        printf("CSV_PIPE_HEADER,op,bits,exp,ops,serial_ops_s,pipe_ops_s,speedup,producer_stalls,consumer_stalls\n");
+        printf("CSV_PIPE,%s,%zu,%s,%zu,%.1f,%.1f,%.2f,%zu,%zu\n", op_name, bits, exp_label, count,
+               serial_rate, pipe_rate, serial_rate > 0.0 ? pipe_rate / serial_rate : 0.0,
+               result.producer_stalls, result.consumer_stalls);
+    } else {
+        printf("  Pipeline run failed\n");
+    }
+
+    if (have_plan) {
+        rsa_exp_plan_free(&plan);
+    }
+    heap_caps_free(wire);
+    heap_caps_free(slot);
+    heap_caps_free(Z);
+}
+
+#define BATCH_POOL_SIZE 8
+
+static const size_t k_batch_sizes[] = {1, 8, 64, 256};
+
+// Batch entries cycle through a small pool of operands so a 256-entry batch
+// at 4096 bits does not need 256 distinct buffers.
+static void benchmark_batch_ctx(const rsa_mont_ctx_t *ctx, size_t bits, size_t iterations,
+                                const uint32_t *E_words, const char *exp_label) {
+    size_t words = bits / 32;
+    size_t max_batch = k_batch_sizes[sizeof(k_batch_sizes) / sizeof(k_batch_sizes[0]) - 1];
+
+    uint32_t *T = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    const mbedtls_mpi **X_ptr = heap_caps_calloc(max_batch, sizeof(*X_ptr), MALLOC_CAP_DEFAULT);
+    const mbedtls_mpi **Y_ptr = heap_caps_calloc(max_batch, sizeof(*Y_ptr), MALLOC_CAP_DEFAULT);
+    mbedtls_mpi **Z_ptr = heap_caps_calloc(max_batch, sizeof(*Z_ptr), MALLOC_CAP_DEFAULT);
+
+    if (!T || !X_ptr || !Y_ptr || !Z_ptr) {
+        printf("Memory allocation failed\n");
+        heap_caps_free(T);
+        heap_caps_free(X_ptr);
+        heap_caps_free(Y_ptr);
+        heap_caps_free(Z_ptr);
         return;
     }
 
-    uint32_t factors[5] = {0};
-    size_t factor_count = 0;
-    uint32_t small_exp = choose_small_exponent(factors, &factor_count);
-    set_small_exponent(E_small, words, small_exp);
-    set_full_exponent(E_full, bits);
+    mbedtls_mpi X_pool[BATCH_POOL_SIZE], Y_pool[BATCH_POOL_SIZE], Z_pool[BATCH_POOL_SIZE];
+    mbedtls_mpi E_mpi;
+    mbedtls_mpi_init(&E_mpi);
+    for (size_t k = 0; k < BATCH_POOL_SIZE; k++) {
+        mbedtls_mpi_init(&X_pool[k]);
+        mbedtls_mpi_init(&Y_pool[k]);
+        mbedtls_mpi_init(&Z_pool[k]);
+    }
+    for (size_t i = 0; i < max_batch; i++) {
+        X_ptr[i] = &X_pool[i % BATCH_POOL_SIZE];
+        Y_ptr[i] = &Y_pool[i % BATCH_POOL_SIZE];
+        Z_ptr[i] = &Z_pool[i % BATCH_POOL_SIZE];
+    }
 
-    printf("Small exponent target ~20000, chosen: %" PRIu32 " (product of %zu primes)\n", small_exp, factor_count);
-    if (factor_count > 0) {
-        printf("  Primes: ");
-        for (size_t i = 0; i < factor_count; i++) {
-            printf("%" PRIu32 "%s", factors[i], (i + 1 < factor_count) ? "*" : "\n");
+    rsa_mpi_set_words(&E_mpi, E_words, words);
+    rsa_exp_plan_t plan;
+    bool plan_ok = (mbedtls_mpi_bitlen(&E_mpi) <= 32)
+                       ? rsa_exp_plan_init_chain(&plan, E_words[0])
+                       : rsa_exp_plan_init(&plan, &E_mpi, 0);
+
+    printf("\n══════════════════════════════════════════\n");
+    printf("Batched Operation Benchmark (%zu-bit, fixed modulus, one peripheral session per batch)\n", bits);
+    printf("Iterations per batch size: %zu\n", iterations);
+    printf("Operand pool: %d\n", BATCH_POOL_SIZE);
+    printf("══════════════════════════════════════════\n");
+    printf("CSV_BATCH_HEADER,op,bits,exp,batch,iter,success,avg_batch_us,per_op_us\n");
+
+    for (size_t op = 0; op < 2 && plan_ok; op++) {
+        const char *op_name = (op == 0) ? "modmult_batch" : "modexp_batch";
+        const char *label = (op == 0) ? "na" : exp_label;
+
+        for (size_t b = 0; b < sizeof(k_batch_sizes) / sizeof(k_batch_sizes[0]); b++) {
+            size_t batch = k_batch_sizes[b];
+            bench_stats_t stats;
+            bench_stats_init(&stats);
+            size_t successful_ops = 0;
+
+            for (size_t i = 0; i < iterations; i++) {
+                for (size_t k = 0; k < BATCH_POOL_SIZE; k++) {
+                    generate_operand(T, bits);
+                    rsa_mpi_set_words(&X_pool[k], T, words);
+                    generate_operand(T, bits);
+                    rsa_mpi_set_words(&Y_pool[k], T, words);
+                }
+
+                uint64_t start = esp_timer_get_time();
+                bool success = (op == 0)
+                                   ? rsa_mod_mult_hw_batch(ctx, X_ptr, Y_ptr, Z_ptr, batch)
+                                   : rsa_mod_exp_hw_batch(ctx, X_ptr, &plan, Z_ptr, batch, false);
+                uint64_t end = esp_timer_get_time();
+
+                if (!success) {
+                    printf("  Failed at iteration %zu (batch %zu)\n", i, batch);
+                    break;
+                }
+                bench_stats_update(&stats, end - start);
+                successful_ops++;
+            }
+
+            if (successful_ops > 0) {
+                double avg_us = bench_stats_avg(&stats);
+                printf("CSV_BATCH,%s,%zu,%s,%zu,%zu,%zu,%.2f,%.2f\n",
+                       op_name, bits, label, batch, iterations, successful_ops,
+                       avg_us, avg_us / (double)batch);
+            }
         }
     }
 
-    printf("Full-domain exponent: %zu-bit random value\n", bits);
+    if (!plan_ok) {
+        printf("Exponent recoding failed\n");
+    } else {
+        rsa_exp_plan_free(&plan);
+    }
+    for (size_t k = 0; k < BATCH_POOL_SIZE; k++) {
+        mbedtls_mpi_free(&X_pool[k]);
+        mbedtls_mpi_free(&Y_pool[k]);
+        mbedtls_mpi_free(&Z_pool[k]);
+    }
+    mbedtls_mpi_free(&E_mpi);
 
-    benchmark_modmult_ctx(&ctx, bits, iter_mult);
-    benchmark_modexp_ctx(&ctx, bits, iter_exp_small, E_small, "small", false);
+    heap_caps_free(T);
+    heap_caps_free(X_ptr);
+    heap_caps_free(Y_ptr);
+    heap_caps_free(Z_ptr);
+}
 
-    if (iter_exp_full > 0) {
-        printf("Note: full-domain exponent timing can be very slow for %zu-bit.\n", bits);
-        benchmark_modexp_ctx(&ctx, bits, iter_exp_full, E_full, "full", true);
+// Multiplier width for the batch-verification benchmark. A bad item whose
+// error has no small-order factor slips through a batch test with
+// probability about 2^-6; small-order errors such as a sign flip slip
+// through far more often (about 1/2 for -1), see rsa_batch_verify
+#define BATCH_VERIFY_MULT_BITS 6
+
+static void benchmark_batch_verify_ctx(const rsa_mont_ctx_t *ctx, size_t bits, size_t iterations,
+                                       uint32_t small_exp) {
+    size_t words = bits / 32;
+    size_t max_batch = k_batch_sizes[sizeof(k_batch_sizes) / sizeof(k_batch_sizes[0]) - 1];
+
+    uint32_t *T = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    const mbedtls_mpi **X_ptr = heap_caps_calloc(max_batch, sizeof(*X_ptr), MALLOC_CAP_DEFAULT);
+    const mbedtls_mpi **Y_ptr = heap_caps_calloc(max_batch, sizeof(*Y_ptr), MALLOC_CAP_DEFAULT);
+    mbedtls_mpi **Z_ptr = heap_caps_calloc(max_batch, sizeof(*Z_ptr), MALLOC_CAP_DEFAULT);
+    bool *valid = heap_caps_calloc(max_batch, sizeof(bool), MALLOC_CAP_DEFAULT);
+
+    if (!T || !X_ptr || !Y_ptr || !Z_ptr || !valid) {
+        printf("Memory allocation failed\n");
+        heap_caps_free(T);
+        heap_caps_free(X_ptr);
+        heap_caps_free(Y_ptr);
+        heap_caps_free(Z_ptr);
+        heap_caps_free(valid);
+        return;
     }
 
-    rsa_mont_ctx_free(&ctx);
+    mbedtls_mpi X_pool[BATCH_POOL_SIZE], Y_pool[BATCH_POOL_SIZE], Z_pool[BATCH_POOL_SIZE];
+    mbedtls_mpi Y_bad;
+    mbedtls_mpi_init(&Y_bad);
+    for (size_t k = 0; k < BATCH_POOL_SIZE; k++) {
+        mbedtls_mpi_init(&X_pool[k]);
+        mbedtls_mpi_init(&Y_pool[k]);
+        mbedtls_mpi_init(&Z_pool[k]);
+    }
+    for (size_t i = 0; i < max_batch; i++) {
+        X_ptr[i] = &X_pool[i % BATCH_POOL_SIZE];
+        Y_ptr[i] = &Y_pool[i % BATCH_POOL_SIZE];
+        Z_ptr[i] = &Z_pool[i % BATCH_POOL_SIZE];
+    }
 
-    heap_caps_free(M);
-    heap_caps_free(E_small);
-    heap_caps_free(E_full);
+    rsa_exp_plan_t plan;
+    bool ok = rsa_exp_plan_init_chain(&plan, small_exp);
+
+    // Valid pairs y = x^e, computed once outside the timed region; the
+    // corrupted item used by the bisection run is y0 + 1
+    for (size_t k = 0; k < BATCH_POOL_SIZE && ok; k++) {
+        generate_operand(T, bits);
+        ok = rsa_mpi_set_words(&X_pool[k], T, words) &&
+             rsa_mod_exp_hw_plan(ctx, &X_pool[k], &plan, &Y_pool[k], false);
+    }
+    if (ok) {
+        ok = mbedtls_mpi_add_int(&Y_bad, &Y_pool[0], 1) == 0 &&
+             mbedtls_mpi_mod_mpi(&Y_bad, &Y_bad, &ctx->M) == 0;
+    }
+
+    printf("\n══════════════════════════════════════════\n");
+    printf("Batch Verification Benchmark (%zu-bit, y = x^%" PRIu32 ", %d-bit multipliers)\n",
+           bits, small_exp, BATCH_VERIFY_MULT_BITS);
+    printf("Iterations per batch size: %zu\n", iterations);
+    printf("Operand pool: %d\n", BATCH_POOL_SIZE);
+    printf("══════════════════════════════════════════\n");
+    printf("CSV_BATCHVERIFY_HEADER,bits,exp,batch,iter,success,indiv_vps,batch_vps,speedup,bisect_us\n");
+
+    for (size_t b = 0; b < sizeof(k_batch_sizes) / sizeof(k_batch_sizes[0]) && ok; b++) {
+        size_t batch = k_batch_sizes[b];
+        bench_stats_t indiv_stats, batch_stats, bisect_stats;
+        bench_stats_init(&indiv_stats);
+        bench_stats_init(&batch_stats);
+        bench_stats_init(&bisect_stats);
+        size_t successful_ops = 0;
+
+        for (size_t i = 0; i < iterations; i++) {
+            // Baseline: one exponentiation and compare per item
+            uint64_t start = esp_timer_get_time();
+            bool success = rsa_mod_exp_hw_batch(ctx, X_ptr, &plan, Z_ptr, batch, false);
+            size_t rejected = 0;
+            for (size_t k = 0; k < batch && success; k++) {
+                rejected += mbedtls_mpi_cmp_mpi(Z_ptr[k], Y_ptr[k]) != 0;
+            }
+            uint64_t indiv_us = esp_timer_get_time() - start;
+            success = success && rejected == 0;
+
+            start = esp_timer_get_time();
+            success = success && rsa_batch_verify(ctx, &plan, X_ptr, Y_ptr, batch,
+                                                  BATCH_VERIFY_MULT_BITS, valid, &rejected);
+            uint64_t batch_us = esp_timer_get_time() - start;
+            success = success && rejected == 0;
+
+            // One bad item at a random position, found by bisection
+            size_t bad_at = esp_random() % batch;
+            const mbedtls_mpi *saved = Y_ptr[bad_at];
+            X_ptr[bad_at] = &X_pool[0];
+            Y_ptr[bad_at] = &Y_bad;
+            start = esp_timer_get_time();
+            success = success && rsa_batch_verify(ctx, &plan, X_ptr, Y_ptr, batch,
+                                                  BATCH_VERIFY_MULT_BITS, valid, &rejected);
+            uint64_t bisect_us = esp_timer_get_time() - start;
+            X_ptr[bad_at] = &X_pool[bad_at % BATCH_POOL_SIZE];
+            Y_ptr[bad_at] = saved;
+            success = success && rejected == 1 && !valid[bad_at];
+
+            if (!success) {
+                printf("  Failed at iteration %zu (batch %zu)\n", i, batch);
+                break;
+            }
+            bench_stats_update(&indiv_stats, indiv_us);
+            bench_stats_update(&batch_stats, batch_us);
+            bench_stats_update(&bisect_stats, bisect_us);
+            successful_ops++;
+        }
+
+        if (successful_ops > 0) {
+            double indiv_avg = bench_stats_avg(&indiv_stats);
+            double batch_avg = bench_stats_avg(&batch_stats);
+            double indiv_vps = indiv_avg > 0.0 ? 1e6 * (double)batch / indiv_avg : 0.0;
+            double batch_vps = batch_avg > 0.0 ? 1e6 * (double)batch / batch_avg : 0.0;
+            printf("  batch %zu: %.1f verifies/s individually, %.1f batched (%.2fx)\n",
+                   batch, indiv_vps, batch_vps, indiv_vps > 0.0 ? batch_vps / indiv_vps : 0.0);
+            printf("CSV_BATCHVERIFY,%zu,%" PRIu32 ",%zu,%zu,%zu,%.1f,%.1f,%.2f,%.2f\n",
+                   bits, small_exp, batch, iterations, successful_ops, indiv_vps, batch_vps,
+                   indiv_vps > 0.0 ? batch_vps / indiv_vps : 0.0, bench_stats_avg(&bisect_stats));
+        }
+    }
+
+    if (!ok) {
+        printf("Batch verification setup failed\n");
+    }
+    rsa_exp_plan_free(&plan);
+    for (size_t k = 0; k < BATCH_POOL_SIZE; k++) {
+        mbedtls_mpi_free(&X_pool[k]);
+        mbedtls_mpi_free(&Y_pool[k]);
+        mbedtls_mpi_free(&Z_pool[k]);
+    }
+    mbedtls_mpi_free(&Y_bad);
+
+    heap_caps_free(T);
+    heap_caps_free(X_ptr);
+    heap_caps_free(Y_ptr);
+    heap_caps_free(Z_ptr);
+    heap_caps_free(valid);
+}
+
+static void benchmark_modexp_ctx(const rsa_mont_ctx_t *ctx, size_t bits, size_t iterations,
+                                 const uint32_t *E_words, const char *exp_label, bool feed_wdt) {
+    size_t words = bits / 32;
+
+    uint32_t *X = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *Z = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+
+    if (!X || !Z) {
+        printf("Memory allocation failed\n");
+        return;
+    }
+
+    mbedtls_mpi X_mpi, E_mpi, Z_mpi;
+    mbedtls_mpi_init(&X_mpi);
+    mbedtls_mpi_init(&E_mpi);
+    mbedtls_mpi_init(&Z_mpi);
+
+    rsa_mpi_set_words(&E_mpi, E_words, words);
+
+    // The exponent is fixed for the whole run, so recode it once up front.
+    // Small exponents get an addition chain instead of a window recoding.
+    rsa_exp_plan_t plan;
+    bool plan_ok = (mbedtls_mpi_bitlen(&E_mpi) <= 32)
+                       ? rsa_exp_plan_init_chain(&plan, E_words[0])
+                       : rsa_exp_plan_init(&plan, &E_mpi, 0);
+    if (!plan_ok) {
+        printf("Exponent recoding failed\n");
+        mbedtls_mpi_free(&E_mpi);
+        heap_caps_free(X);
+        heap_caps_free(Z);
+        return;
+    }
+
+    const size_t warmup = 1;
+    printf("\n══════════════════════════════════════════\n");
+    printf("Modular Exponentiation Benchmark (%zu-bit, %s exponent, fixed modulus)\n", bits, exp_label);
+    printf("Iterations: %zu\n", iterations);
+    printf("Warm-up iterations: %zu\n", warmup);
+    if (plan.is_chain) {
+        printf("Exponent plan: addition chain, montmuls=%zu\n", rsa_exp_plan_montmuls(&plan));
+    } else {
+        printf("Exponent plan: window=%zu, table=%zu, montmuls=%zu\n",
+               plan.window, plan.table_size, rsa_exp_plan_montmuls(&plan));
+    }
+    printf("══════════════════════════════════════════\n");
+
+    for (size_t i = 0; i < warmup; i++) {
+        generate_operand(X, bits);
+        rsa_mpi_set_words(&X_mpi, X, words);
+        (void)rsa_mod_exp_hw_plan(ctx, &X_mpi, &plan, &Z_mpi, feed_wdt);
+    }
+
+    bench_stats_t stats, cycle_stats;
+    bench_stats_init(&stats);
+    bench_stats_init(&cycle_stats);
+    size_t successful_ops = 0;
+    size_t heap_calls = 0;
+
+    printf("\nStarting benchmark...\n");
+
+    ops_reset();
+    for (size_t i = 0; i < iterations; i++) {
+        generate_operand(X, bits);
+        rsa_mpi_set_words(&X_mpi, X, words);
+
+        size_t heap_before = rsa_heap_calls();
+        bench_timer_t timer;
+        bench_sample_t sample;
+        ops_begin();
+        bench_timer_start(&timer);
+        bool success = rsa_mod_exp_hw_plan(ctx, &X_mpi, &plan, &Z_mpi, feed_wdt);
+        bench_timer_stop(&timer, &sample);
+        ops_end();
+        heap_calls += rsa_heap_calls() - heap_before;
+
+        if (success) {
+            bench_stats_update(&stats, sample.us);
+            bench_stats_update(&cycle_stats, sample.cycles);
+            successful_ops++;
+            bench_log_record("modexp", bits, exp_label, i + 1, sample.us, &sample);
+
+            if (iterations >= 5 && (i + 1) % (iterations / 5) == 0) {
+                printf("  Progress: %zu/%zu\n", i + 1, iterations);
+            }
+        } else {
+            printf("  Failed at iteration %zu\n", i);
+            break;
+        }
+    }
+
+    if (successful_ops > 0) {
+        double avg_us = bench_stats_avg(&stats);
+        double stddev_us = bench_stats_stddev(&stats);
+        printf("\nBenchmark Results:\n");
+        printf("  Successful operations: %zu/%zu\n", successful_ops, iterations);
+        printf("  Total time: %" PRIu64 " µs\n", stats.total);
+        printf("  Average time: %.2f µs\n", avg_us);
+        printf("  Average time: %.2f ms\n", avg_us / 1000.0);
+        printf("  Stddev: %.2f µs\n", stddev_us);
+        printf("  Min: %" PRIu64 " µs\n", stats.min);
+        printf("  Max: %" PRIu64 " µs\n", stats.max);
+
+        rsa_mpi_get_words(&Z_mpi, Z, words);
+        bool any_nonzero = false;
+        for (size_t i = 0; i < words; i++) {
+            if (Z[i] != 0) {
+                any_nonzero = true;
+                break;
+            }
+        }
+        printf("  Result is %s\n", any_nonzero ? "non-zero ✓" : "zero ⚠");
+
+        csv_summary("modexp", bits, exp_label, iterations, successful_ops, &stats);
+        csv_cyc_summary("modexp", bits, exp_label, successful_ops, &cycle_stats);
+        csv_scale(bits, "native", "modexp", exp_label, avg_us, (double)rsa_exp_plan_montmuls(&plan));
+        csv_heap("modexp", bits, exp_label, successful_ops, heap_calls);
+    } else {
+        printf("\nNo successful operations!\n");
+    }
+
+    rsa_exp_plan_free(&plan);
+    mbedtls_mpi_free(&X_mpi);
+    mbedtls_mpi_free(&E_mpi);
+    mbedtls_mpi_free(&Z_mpi);
+
+    heap_caps_free(X);
+    heap_caps_free(Z);
+}
+
+#define ASYNC_CALIBRATE_UNITS 2000
+#define ASYNC_TIMEOUT_MS 60000
+
+static volatile uint32_t s_work_sink;
+
+// Fixed slice of CPU-only work standing in for "prepare the next operand".
+static void async_work_unit(void) {
+    uint32_t x = s_work_sink | 1;
+    for (int i = 0; i < 64; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+    }
+    s_work_sink = x;
+}
+
+// CPU time handed back while an exponentiation is in flight: the submitting
+// task does work units until the interrupt chain completes, and the units
+// (at their calibrated cost) are compared with the end-to-end time.
+static void benchmark_async_ctx(const rsa_mont_ctx_t *ctx, size_t bits, size_t iterations,
+                                const uint32_t *E_words, const char *exp_label) {
+    size_t words = bits / 32;
+
+    uint32_t *X = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *Z_sync = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *Z_async = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+
+    if (!X || !Z_sync || !Z_async) {
+        printf("Memory allocation failed\n");
+        heap_caps_free(X);
+        heap_caps_free(Z_sync);
+        heap_caps_free(Z_async);
+        return;
+    }
+
+    mbedtls_mpi E_mpi;
+    mbedtls_mpi_init(&E_mpi);
+    rsa_mpi_set_words(&E_mpi, E_words, words);
+
+    rsa_exp_plan_t plan;
+    bool plan_ok = (mbedtls_mpi_bitlen(&E_mpi) <= 32)
+                       ? rsa_exp_plan_init_chain(&plan, E_words[0])
+                       : rsa_exp_plan_init(&plan, &E_mpi, 0);
+    mbedtls_mpi_free(&E_mpi);
+    if (!plan_ok) {
+        printf("Exponent recoding failed\n");
+        heap_caps_free(X);
+        heap_caps_free(Z_sync);
+        heap_caps_free(Z_async);
+        return;
+    }
+
+    uint64_t start = esp_timer_get_time();
+    for (size_t i = 0; i < ASYNC_CALIBRATE_UNITS; i++) {
+        async_work_unit();
+    }
+    double unit_us = (double)(esp_timer_get_time() - start) / (double)ASYNC_CALIBRATE_UNITS;
+
+    printf("\n══════════════════════════════════════════\n");
+    printf("Async Modexp Benchmark (%zu-bit, %s exponent, interrupt-driven)\n", bits, exp_label);
+    printf("Iterations: %zu\n", iterations);
+    printf("Work unit: %.3f µs\n", unit_us);
+    printf("══════════════════════════════════════════\n");
+    printf("CSV_ASYNC_HEADER,op,bits,exp,iter,sync_us,async_us,work_units,work_us,cpu_free_pct\n");
+
+    bench_stats_t sync_stats, async_stats;
+    bench_stats_init(&sync_stats);
+    bench_stats_init(&async_stats);
+    double free_pct_total = 0.0;
+    size_t successful_ops = 0;
+
+    for (size_t i = 0; i < iterations; i++) {
+        generate_operand(X, bits);
+
+        start = esp_timer_get_time();
+        bool ok = rsa_mod_exp_hw_words(ctx, X, &plan, Z_sync, true);
+        uint64_t sync_us = esp_timer_get_time() - start;
+
+        rsa_async_t op;
+        size_t units = 0;
+        start = esp_timer_get_time();
+        ok = ok && rsa_async_exp_start(&op, ctx, X, &plan, Z_async, NULL, NULL);
+        if (ok) {
+            while (!rsa_async_done(&op)) {
+                async_work_unit();
+                units++;
+            }
+            ok = rsa_async_wait(&op, ASYNC_TIMEOUT_MS);
+        }
+        uint64_t async_us = esp_timer_get_time() - start;
+
+        if (!ok || memcmp(Z_sync, Z_async, words * sizeof(uint32_t)) != 0) {
+            printf("  Failed at iteration %zu (%s)\n", i, ok ? "result mismatch" : "op failed");
+            break;
+        }
+
+        double work_us = (double)units * unit_us;
+        double free_pct = async_us ? 100.0 * work_us / (double)async_us : 0.0;
+        bench_stats_update(&sync_stats, sync_us);
+        bench_stats_update(&async_stats, async_us);
+        free_pct_total += free_pct;
+        successful_ops++;
+        printf("CSV_ASYNC,modexp_async,%zu,%s,%zu,%" PRIu64 ",%" PRIu64 ",%zu,%.2f,%.2f\n",
+               bits, exp_label, i + 1, sync_us, async_us, units, work_us, free_pct);
+    }
+
+    if (successful_ops > 0) {
+        printf("\nAsync Results:\n");
+        printf("  Sync average: %.2f µs\n", bench_stats_avg(&sync_stats));
+        printf("  Async average: %.2f µs\n", bench_stats_avg(&async_stats));
+        printf("  CPU recovered: %.2f%%\n", free_pct_total / (double)successful_ops);
+        csv_summary("modexp_async", bits, exp_label, iterations, successful_ops, &async_stats);
+    }
+
+    rsa_exp_plan_free(&plan);
+    heap_caps_free(X);
+    heap_caps_free(Z_sync);
+    heap_caps_free(Z_async);
+}
+
+static const size_t k_fixed_base_teeth[] = {4, 6, 8};
+
+// One base, many full-size exponents: comb table precomputation once, then
+// each exponentiation against the sliding-window path on the same exponent.
+static void benchmark_fixedbase_ctx(const rsa_mont_ctx_t *ctx, size_t bits, size_t iterations) {
+    size_t words = bits / 32;
+
+    uint32_t *G = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *E = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+
+    if (!G || !E) {
+        printf("Memory allocation failed\n");
+        heap_caps_free(G);
+        heap_caps_free(E);
+        return;
+    }
+
+    mbedtls_mpi G_mpi, E_mpi, Z_fixed, Z_generic;
+    mbedtls_mpi_init(&G_mpi);
+    mbedtls_mpi_init(&E_mpi);
+    mbedtls_mpi_init(&Z_fixed);
+    mbedtls_mpi_init(&Z_generic);
+
+    generate_operand(G, bits);
+    rsa_mpi_set_words(&G_mpi, G, words);
+
+    printf("\n══════════════════════════════════════════\n");
+    printf("Fixed-Base Modexp Benchmark (%zu-bit, full exponent, comb table)\n", bits);
+    printf("Iterations: %zu\n", iterations);
+    printf("══════════════════════════════════════════\n");
+    printf("CSV_FIXEDBASE_HEADER,bits,teeth,mem,entries,table_bytes,precomp_us,precomp_montmuls,fixed_us,generic_us,speedup\n");
+
+    for (size_t t = 0; t < sizeof(k_fixed_base_teeth) / sizeof(k_fixed_base_teeth[0]); t++) {
+        size_t teeth = k_fixed_base_teeth[t];
+        rsa_fixed_base_ctx_t fb;
+
+        // Large tables fall back to PSRAM when internal RAM is short
+        const char *mem = "dram";
+        uint64_t start = esp_timer_get_time();
+        bool ok = rsa_fixed_base_init(&fb, ctx, &G_mpi, bits, teeth, MALLOC_CAP_INTERNAL);
+        if (!ok) {
+            mem = "psram";
+            start = esp_timer_get_time();
+            ok = rsa_fixed_base_init(&fb, ctx, &G_mpi, bits, teeth, MALLOC_CAP_SPIRAM);
+        }
+        uint64_t precomp_us = esp_timer_get_time() - start;
+        if (!ok) {
+            printf("  teeth=%zu: no memory for the table, skipped\n", teeth);
+            continue;
+        }
+
+        char label[16];
+        snprintf(label, sizeof(label), "teeth%zu", teeth);
+
+        bench_stats_t fixed_stats, generic_stats;
+        bench_stats_init(&fixed_stats);
+        bench_stats_init(&generic_stats);
+        size_t successful_ops = 0;
+
+        ops_reset();
+        for (size_t i = 0; i < iterations; i++) {
+            set_full_exponent(E, bits);
+            rsa_mpi_set_words(&E_mpi, E, words);
+
+            ops_begin();
+            start = esp_timer_get_time();
+            bool success = rsa_fixed_base_exp(&fb, &E_mpi, &Z_fixed);
+            uint64_t fixed_us = esp_timer_get_time() - start;
+            ops_end();
+
+            start = esp_timer_get_time();
+            success = rsa_mod_exp_hw_ctx(ctx, &G_mpi, &E_mpi, &Z_generic, true) && success;
+            uint64_t generic_us = esp_timer_get_time() - start;
+
+            if (!success || mbedtls_mpi_cmp_mpi(&Z_fixed, &Z_generic) != 0) {
+                printf("  Failed at iteration %zu (%s)\n", i, success ? "result mismatch" : "op failed");
+                break;
+            }
+            bench_stats_update(&fixed_stats, fixed_us);
+            bench_stats_update(&generic_stats, generic_us);
+            successful_ops++;
+            bench_log_record("modexp_fixedbase", bits, label, i + 1, fixed_us, NULL);
+        }
+
+        if (successful_ops > 0) {
+            double fixed_avg = bench_stats_avg(&fixed_stats);
+            double generic_avg = bench_stats_avg(&generic_stats);
+            printf("  teeth=%zu: %zu entries, %zu bytes in %s, precomp %" PRIu64 " µs (%zu montmuls)\n",
+                   teeth, fb.entries, rsa_fixed_base_table_bytes(&fb), mem, precomp_us, fb.precomp_montmuls);
+            printf("    fixed-base %.2f µs vs window %.2f µs (%.2fx)\n",
+                   fixed_avg, generic_avg, fixed_avg > 0.0 ? generic_avg / fixed_avg : 0.0);
+            csv_summary("modexp_fixedbase", bits, label, iterations, successful_ops, &fixed_stats);
+            printf("CSV_FIXEDBASE,%zu,%zu,%s,%zu,%zu,%" PRIu64 ",%zu,%.2f,%.2f,%.2f\n",
+                   bits, teeth, mem, fb.entries, rsa_fixed_base_table_bytes(&fb), precomp_us, fb.precomp_montmuls,
+                   fixed_avg, generic_avg, fixed_avg > 0.0 ? generic_avg / fixed_avg : 0.0);
+        }
+
+        rsa_fixed_base_free(&fb);
+    }
+
+    mbedtls_mpi_free(&G_mpi);
+    mbedtls_mpi_free(&E_mpi);
+    mbedtls_mpi_free(&Z_fixed);
+    mbedtls_mpi_free(&Z_generic);
+    heap_caps_free(G);
+    heap_caps_free(E);
+}
+
+// x^a * y^b (* z^c ...) mod M: separate exponentiations folded with
+// modmults, against one interleaved multi-exponentiation.
+static void benchmark_multiexp_ctx(const rsa_mont_ctx_t *ctx, size_t bits, size_t iterations) {
+    size_t words = bits / 32;
+
+    uint32_t *W = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    if (!W) {
+        printf("Memory allocation failed\n");
+        return;
+    }
+
+    mbedtls_mpi X[RSA_MULTI_EXP_MAX], E[RSA_MULTI_EXP_MAX], T, Z_naive, Z_multi;
+    const mbedtls_mpi *X_ptrs[RSA_MULTI_EXP_MAX];
+    const mbedtls_mpi *E_ptrs[RSA_MULTI_EXP_MAX];
+    for (size_t b = 0; b < RSA_MULTI_EXP_MAX; b++) {
+        mbedtls_mpi_init(&X[b]);
+        mbedtls_mpi_init(&E[b]);
+        X_ptrs[b] = &X[b];
+        E_ptrs[b] = &E[b];
+    }
+    mbedtls_mpi_init(&T);
+    mbedtls_mpi_init(&Z_naive);
+    mbedtls_mpi_init(&Z_multi);
+
+    printf("\n══════════════════════════════════════════\n");
+    printf("Multi-Exponentiation Benchmark (%zu-bit, full exponents)\n", bits);
+    printf("Iterations: %zu\n", iterations);
+    printf("══════════════════════════════════════════\n");
+    printf("CSV_MULTIEXP_HEADER,bits,bases,iter,success,naive_us,multi_us,speedup\n");
+
+    for (size_t count = 2; count <= RSA_MULTI_EXP_MAX; count++) {
+        char label[16];
+        snprintf(label, sizeof(label), "bases%zu", count);
+
+        bench_stats_t naive_stats, multi_stats;
+        bench_stats_init(&naive_stats);
+        bench_stats_init(&multi_stats);
+        size_t successful_ops = 0;
+
+        ops_reset();
+        for (size_t i = 0; i < iterations; i++) {
+            for (size_t b = 0; b < count; b++) {
+                generate_operand(W, bits);
+                rsa_mpi_set_words(&X[b], W, words);
+                set_full_exponent(W, bits);
+                rsa_mpi_set_words(&E[b], W, words);
+            }
+
+            uint64_t start = esp_timer_get_time();
+            bool success = rsa_mod_exp_hw_ctx(ctx, &X[0], &E[0], &Z_naive, true);
+            for (size_t b = 1; b < count && success; b++) {
+                success = rsa_mod_exp_hw_ctx(ctx, &X[b], &E[b], &T, true) &&
+                          rsa_mod_mult_hw_ctx(ctx, &Z_naive, &T, &Z_naive);
+            }
+            uint64_t naive_us = esp_timer_get_time() - start;
+
+            ops_begin();
+            start = esp_timer_get_time();
+            success = rsa_mod_multi_exp_hw(ctx, X_ptrs, E_ptrs, count, &Z_multi) && success;
+            uint64_t multi_us = esp_timer_get_time() - start;
+            ops_end();
+
+            if (!success || mbedtls_mpi_cmp_mpi(&Z_naive, &Z_multi) != 0) {
+                printf("  Failed at iteration %zu (%s)\n", i, success ? "result mismatch" : "op failed");
+                break;
+            }
+            bench_stats_update(&naive_stats, naive_us);
+            bench_stats_update(&multi_stats, multi_us);
+            successful_ops++;
+            bench_log_record("modexp_multi", bits, label, i + 1, multi_us, NULL);
+        }
+
+        if (successful_ops > 0) {
+            double naive_avg = bench_stats_avg(&naive_stats);
+            double multi_avg = bench_stats_avg(&multi_stats);
+            printf("  %zu bases: naive %.2f µs, interleaved %.2f µs (%.2fx)\n",
+                   count, naive_avg, multi_avg, multi_avg > 0.0 ? naive_avg / multi_avg : 0.0);
+            csv_summary("modexp_multi", bits, label, iterations, successful_ops, &multi_stats);
+            printf("CSV_MULTIEXP,%zu,%zu,%zu,%zu,%.2f,%.2f,%.2f\n", bits, count, iterations, successful_ops,
+                   naive_avg, multi_avg, multi_avg > 0.0 ? naive_avg / multi_avg : 0.0);
+        }
+    }
+
+    for (size_t b = 0; b < RSA_MULTI_EXP_MAX; b++) {
+        mbedtls_mpi_free(&X[b]);
+        mbedtls_mpi_free(&E[b]);
+    }
+    mbedtls_mpi_free(&T);
+    mbedtls_mpi_free(&Z_naive);
+    mbedtls_mpi_free(&Z_multi);
+    heap_caps_free(W);
+}
+
+#define CRT_PUBLIC_EXPONENT 65537
+
+static int bench_rng(void *arg, unsigned char *buf, size_t len) {
+    (void)arg;
+    esp_fill_random(buf, len);
+    return 0;
+}
+
+// Prime-pair key: P and Q of bits/2 each (mbedtls keeps their top bits high,
+// so N = PQ has exactly `bits` bits) and D = e^-1 mod lcm(P-1, Q-1).
+static bool generate_crt_key(size_t bits, mbedtls_mpi *P, mbedtls_mpi *Q, mbedtls_mpi *N, mbedtls_mpi *D) {
+    mbedtls_mpi P1, Q1, G, L, E;
+    mbedtls_mpi_init(&P1);
+    mbedtls_mpi_init(&Q1);
+    mbedtls_mpi_init(&G);
+    mbedtls_mpi_init(&L);
+    mbedtls_mpi_init(&E);
+
+    bool ok = mbedtls_mpi_lset(&E, CRT_PUBLIC_EXPONENT) == 0;
+    bool found = false;
+    while (ok && !found) {
+        ok = mbedtls_mpi_gen_prime(P, bits / 2, 0, bench_rng, NULL) == 0 &&
+             mbedtls_mpi_gen_prime(Q, bits / 2, 0, bench_rng, NULL) == 0 &&
+             mbedtls_mpi_mul_mpi(N, P, Q) == 0 &&
+             mbedtls_mpi_sub_int(&P1, P, 1) == 0 &&
+             mbedtls_mpi_sub_int(&Q1, Q, 1) == 0 &&
+             mbedtls_mpi_gcd(&G, &P1, &Q1) == 0 &&
+             mbedtls_mpi_mul_mpi(&L, &P1, &Q1) == 0 &&
+             mbedtls_mpi_div_mpi(&L, NULL, &L, &G) == 0;
+        if (!ok || mbedtls_mpi_cmp_mpi(P, Q) == 0 || mbedtls_mpi_bitlen(N) != bits) {
+            continue;
+        }
+        // e must be invertible mod lcm(P-1, Q-1); otherwise draw again
+        found = mbedtls_mpi_inv_mod(D, &E, &L) == 0;
+    }
+
+    mbedtls_mpi_free(&P1);
+    mbedtls_mpi_free(&Q1);
+    mbedtls_mpi_free(&G);
+    mbedtls_mpi_free(&L);
+    mbedtls_mpi_free(&E);
+    return ok && found;
+}
+
+// Private-key exponentiation with a generated key: X^D mod N on the
+// full-size context against the CRT path on the two half-size contexts.
+static void benchmark_crt(size_t bits, size_t iterations) {
+    size_t words = bits / 32;
+
+    uint32_t *W = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    if (!W) {
+        printf("Memory allocation failed\n");
+        return;
+    }
+
+    mbedtls_mpi P, Q, N, D, X, Z_plain, Z_crt;
+    mbedtls_mpi_init(&P);
+    mbedtls_mpi_init(&Q);
+    mbedtls_mpi_init(&N);
+    mbedtls_mpi_init(&D);
+    mbedtls_mpi_init(&X);
+    mbedtls_mpi_init(&Z_plain);
+    mbedtls_mpi_init(&Z_crt);
+
+    printf("\n══════════════════════════════════════════\n");
+    printf("CRT Modexp Benchmark (%zu-bit key, two %zu-bit halves)\n", bits, bits / 2);
+    printf("Iterations: %zu\n", iterations);
+    printf("══════════════════════════════════════════\n");
+
+    uint64_t start = esp_timer_get_time();
+    bool ok = generate_crt_key(bits, &P, &Q, &N, &D);
+    uint64_t keygen_us = esp_timer_get_time() - start;
+    if (!ok) {
+        printf("Key generation failed\n");
+        goto cleanup;
+    }
+    printf("Key generation: %" PRIu64 " µs\n", keygen_us);
+
+    rsa_mont_ctx_t n_ctx;
+    rsa_crt_ctx_t crt;
+    rsa_exp_plan_t d_plan;
+    rsa_mpi_get_words(&N, W, words);
+    if (!rsa_mont_ctx_init(&n_ctx, W, words)) {
+        printf("Failed to initialize Montgomery context\n");
+        goto cleanup;
+    }
+    if (!rsa_crt_ctx_init(&crt, &P, &Q, &D)) {
+        printf("Failed to initialize CRT context\n");
+        rsa_mont_ctx_free(&n_ctx);
+        goto cleanup;
+    }
+    if (!rsa_exp_plan_init(&d_plan, &D, 0)) {
+        printf("Exponent recoding failed\n");
+        rsa_crt_ctx_free(&crt);
+        rsa_mont_ctx_free(&n_ctx);
+        goto cleanup;
+    }
+
+    bench_stats_t plain_stats, crt_stats;
+    bench_stats_init(&plain_stats);
+    bench_stats_init(&crt_stats);
+    size_t successful_ops = 0;
+
+    ops_reset();
+    for (size_t i = 0; i < iterations; i++) {
+        generate_operand(W, bits);
+        rsa_mpi_set_words(&X, W, words);
+        mbedtls_mpi_mod_mpi(&X, &X, &N);
+
+        start = esp_timer_get_time();
+        bool success = rsa_mod_exp_hw_plan(&n_ctx, &X, &d_plan, &Z_plain, true);
+        uint64_t plain_us = esp_timer_get_time() - start;
+
+        ops_begin();
+        start = esp_timer_get_time();
+        success = rsa_mod_exp_crt(&crt, &X, &Z_crt) && success;
+        uint64_t crt_us = esp_timer_get_time() - start;
+        ops_end();
+
+        if (!success || mbedtls_mpi_cmp_mpi(&Z_plain, &Z_crt) != 0) {
+            printf("  Failed at iteration %zu (%s)\n", i, success ? "result mismatch" : "op failed");
+            break;
+        }
+        bench_stats_update(&plain_stats, plain_us);
+        bench_stats_update(&crt_stats, crt_us);
+        successful_ops++;
+        bench_log_record("modexp_crt", bits, "private", i + 1, crt_us, NULL);
+    }
+
+    if (successful_ops > 0) {
+        double plain_avg = bench_stats_avg(&plain_stats);
+        double crt_avg = bench_stats_avg(&crt_stats);
+        printf("  Full-size: %.2f µs, CRT: %.2f µs (%.2fx)\n",
+               plain_avg, crt_avg, crt_avg > 0.0 ? plain_avg / crt_avg : 0.0);
+        csv_summary("modexp_crt", bits, "private", iterations, successful_ops, &crt_stats);
+        printf("CSV_CRT_HEADER,bits,iter,success,keygen_us,plain_us,crt_us,speedup\n");
+        printf("CSV_CRT,%zu,%zu,%zu,%" PRIu64 ",%.2f,%.2f,%.2f\n", bits, iterations, successful_ops,
+               keygen_us, plain_avg, crt_avg, crt_avg > 0.0 ? plain_avg / crt_avg : 0.0);
+    }
+
+    rsa_exp_plan_free(&d_plan);
+    rsa_crt_ctx_free(&crt);
+    rsa_mont_ctx_free(&n_ctx);
+
+cleanup:
+    mbedtls_mpi_free(&P);
+    mbedtls_mpi_free(&Q);
+    mbedtls_mpi_free(&N);
+    mbedtls_mpi_free(&D);
+    mbedtls_mpi_free(&X);
+    mbedtls_mpi_free(&Z_plain);
+    mbedtls_mpi_free(&Z_crt);
+    heap_caps_free(W);
+}
+
+// Context setup latency for the suite's modulus. The ctx_rr_sw op times
+// the software R^2 mod M reduction the accelerator path replaced.
+static void benchmark_ctx_init(const uint32_t *M, size_t bits, size_t iterations) {
+    size_t words = bits / 32;
+    size_t hw_words = esp_mpi_hardware_words(words);
+
+    printf("\n══════════════════════════════════════════\n");
+    printf("Context Init Benchmark (%zu-bit)\n", bits);
+    printf("Iterations: %zu\n", iterations);
+    printf("══════════════════════════════════════════\n");
+
+    bench_stats_t stats;
+    bench_stats_init(&stats);
+    size_t successful_ops = 0;
+
+    ops_reset();
+    for (size_t i = 0; i < iterations; i++) {
+        rsa_mont_ctx_t ctx;
+        ops_begin();
+        uint64_t start = esp_timer_get_time();
+        bool success = rsa_mont_ctx_init(&ctx, M, words);
+        uint64_t end = esp_timer_get_time();
+        ops_end();
+        if (!success) {
+            printf("  Failed at iteration %zu\n", i);
+            break;
+        }
+        rsa_mont_ctx_free(&ctx);
+        bench_stats_update(&stats, end - start);
+        successful_ops++;
+        bench_log_record("ctx_init", bits, "na", i + 1, end - start, NULL);
+    }
+    if (successful_ops > 0) {
+        printf("  Average: %.2f µs\n", bench_stats_avg(&stats));
+        csv_summary("ctx_init", bits, "na", iterations, successful_ops, &stats);
+    }
+
+    mbedtls_mpi M_mpi, RR;
+    mbedtls_mpi_init(&M_mpi);
+    mbedtls_mpi_init(&RR);
+    rsa_mpi_set_words(&M_mpi, M, words);
+    bench_stats_init(&stats);
+    successful_ops = 0;
+    for (size_t i = 0; i < iterations; i++) {
+        uint64_t start = esp_timer_get_time();
+        bool success = mbedtls_mpi_lset(&RR, 1) == 0 &&
+                       mbedtls_mpi_shift_l(&RR, hw_words * 2 * 32) == 0 &&
+                       mbedtls_mpi_mod_mpi(&RR, &RR, &M_mpi) == 0;
+        uint64_t end = esp_timer_get_time();
+        if (!success) {
+            break;
+        }
+        bench_stats_update(&stats, end - start);
+        successful_ops++;
+    }
+    if (successful_ops > 0) {
+        printf("  Software R^2 mod M alone: %.2f µs\n", bench_stats_avg(&stats));
+        csv_summary("ctx_rr_sw", bits, "na", iterations, successful_ops, &stats);
+    }
+    mbedtls_mpi_free(&M_mpi);
+    mbedtls_mpi_free(&RR);
+}
+
+// Moduli rotated through the context cache, and its capacity: rotations up
+// to the capacity stay hot, the last one cycles more moduli than fit.
+#define CTX_CACHE_CAPACITY 4
+static const size_t k_cache_moduli[] = {2, 4, 8};
+
+// Per-switch cost of getting a usable context when the modulus changes:
+// cold builds a fresh rsa_mont_ctx_t every time, hot goes through the LRU
+// cache. Each switch is followed by one modmult to show the context works.
+static void benchmark_ctx_cache(size_t bits, size_t iterations) {
+    size_t words = bits / 32;
+    size_t max_moduli = k_cache_moduli[sizeof(k_cache_moduli) / sizeof(k_cache_moduli[0]) - 1];
+
+    uint32_t *M = heap_caps_calloc(max_moduli * words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *X = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    if (!M || !X) {
+        printf("Memory allocation failed\n");
+        heap_caps_free(M);
+        heap_caps_free(X);
+        return;
+    }
+    for (size_t k = 0; k < max_moduli; k++) {
+        generate_modulus(&M[k * words], bits);
+    }
+
+    mbedtls_mpi X_mpi, Z_mpi;
+    mbedtls_mpi_init(&X_mpi);
+    mbedtls_mpi_init(&Z_mpi);
+    generate_operand(X, bits);
+    rsa_mpi_set_words(&X_mpi, X, words);
+
+    printf("\n══════════════════════════════════════════\n");
+    printf("Context Cache Benchmark (%zu-bit, LRU capacity %d)\n", bits, CTX_CACHE_CAPACITY);
+    printf("Switches per run: %zu\n", iterations);
+    printf("══════════════════════════════════════════\n");
+    printf("CSV_CTXCACHE_HEADER,bits,moduli,capacity,switches,cold_us,hot_us,hits,misses,evictions\n");
+
+    for (size_t c = 0; c < sizeof(k_cache_moduli) / sizeof(k_cache_moduli[0]); c++) {
+        size_t moduli = k_cache_moduli[c];
+        bench_stats_t cold_stats, hot_stats;
+        bench_stats_init(&cold_stats);
+        bench_stats_init(&hot_stats);
+        bool ok = true;
+
+        for (size_t i = 0; i < iterations && ok; i++) {
+            const uint32_t *Mk = &M[(i % moduli) * words];
+            rsa_mont_ctx_t ctx;
+            uint64_t start = esp_timer_get_time();
+            ok = rsa_mont_ctx_init(&ctx, Mk, words);
+            uint64_t end = esp_timer_get_time();
+            if (ok) {
+                bench_stats_update(&cold_stats, end - start);
+                ok = rsa_mod_mult_hw_ctx(&ctx, &X_mpi, &X_mpi, &Z_mpi);
+                rsa_mont_ctx_free(&ctx);
+            }
+        }
+
+        rsa_ctx_cache_t cache = {0};
+        ok = ok && rsa_ctx_cache_init(&cache, CTX_CACHE_CAPACITY);
+        if (ok) {
+            // One pass over the moduli to fill the cache before timing
+            for (size_t k = 0; k < moduli && ok; k++) {
+                ok = rsa_ctx_cache_get(&cache, &M[k * words], words) != NULL;
+            }
+            cache.hits = cache.misses = cache.evictions = 0;
+
+            for (size_t i = 0; i < iterations && ok; i++) {
+                uint64_t start = esp_timer_get_time();
+                const rsa_mont_ctx_t *ctx = rsa_ctx_cache_get(&cache, &M[(i % moduli) * words], words);
+                uint64_t end = esp_timer_get_time();
+                ok = ctx && rsa_mod_mult_hw_ctx(ctx, &X_mpi, &X_mpi, &Z_mpi);
+                bench_stats_update(&hot_stats, end - start);
+            }
+        }
+
+        if (!ok) {
+            printf("  %zu moduli: failed\n", moduli);
+        } else {
+            double cold_avg = bench_stats_avg(&cold_stats);
+            double hot_avg = bench_stats_avg(&hot_stats);
+            printf("  %zu moduli: cold init %.2f µs, cached %.2f µs per switch (%zu hits, %zu misses)\n",
+                   moduli, cold_avg, hot_avg, cache.hits, cache.misses);
+            printf("CSV_CTXCACHE,%zu,%zu,%d,%zu,%.2f,%.2f,%zu,%zu,%zu\n", bits, moduli, CTX_CACHE_CAPACITY,
+                   iterations, cold_avg, hot_avg, cache.hits, cache.misses, cache.evictions);
+        }
+        rsa_ctx_cache_free(&cache);
+    }
+
+    mbedtls_mpi_free(&X_mpi);
+    mbedtls_mpi_free(&Z_mpi);
+    heap_caps_free(M);
+    heap_caps_free(X);
+}
+
+// Wide-modulus modmult (E_words NULL) or modexp through rsa_big_ctx_t. The
+// warm-up result is checked against mbedtls before timing.
+static void benchmark_big_op(const rsa_big_ctx_t *ctx, size_t bits, size_t iterations,
+                             const uint32_t *E_words, const char *exp_label) {
+    size_t words = bits / 32;
+    const char *op_name = E_words ? "modexp" : "modmult";
+
+    uint32_t *X = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *Y = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *Z = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    if (!X || !Y || !Z) {
+        printf("Memory allocation failed\n");
+        heap_caps_free(X);
+        heap_caps_free(Y);
+        heap_caps_free(Z);
+        return;
+    }
+
+    mbedtls_mpi X_mpi, Y_mpi, M_mpi, R_mpi, Z_mpi;
+    mbedtls_mpi_init(&X_mpi);
+    mbedtls_mpi_init(&Y_mpi);
+    mbedtls_mpi_init(&M_mpi);
+    mbedtls_mpi_init(&R_mpi);
+    mbedtls_mpi_init(&Z_mpi);
+    rsa_mpi_set_words(&M_mpi, ctx->M, words);
+
+    rsa_exp_plan_t plan;
+    memset(&plan, 0, sizeof(plan));
+    bool ok = true;
+    if (E_words) {
+        rsa_mpi_set_words(&Y_mpi, E_words, words);
+        ok = (mbedtls_mpi_bitlen(&Y_mpi) <= 32) ? rsa_exp_plan_init_chain(&plan, E_words[0])
+                                                : rsa_exp_plan_init(&plan, &Y_mpi, 0);
+    }
+
+    printf("\n══════════════════════════════════════════\n");
+    if (E_words) {
+        printf("Wide-Modulus Exponentiation Benchmark (%zu-bit, %s exponent)\n", bits, exp_label);
+    } else {
+        printf("Wide-Modulus Multiplication Benchmark (%zu-bit)\n", bits);
+    }
+    printf("Karatsuba over %d-bit hardware multiplies\n", RSA_BIG_BASE_WORDS * 32);
+    printf("Iterations: %zu\n", iterations);
+    printf("══════════════════════════════════════════\n");
+
+    // Warm-up doubles as the correctness check
+    if (ok) {
+        generate_operand(X, bits);
+        generate_operand(Y, bits);
+        rsa_mpi_set_words(&X_mpi, X, words);
+        if (E_words) {
+            ok = rsa_big_mod_exp(ctx, X, &plan, Z) &&
+                 mbedtls_mpi_exp_mod(&R_mpi, &X_mpi, &Y_mpi, &M_mpi, NULL) == 0;
+        } else {
+            rsa_mpi_set_words(&Y_mpi, Y, words);
+            ok = rsa_big_mod_mult(ctx, X, Y, Z) &&
+                 mbedtls_mpi_mul_mpi(&R_mpi, &X_mpi, &Y_mpi) == 0 &&
+                 mbedtls_mpi_mod_mpi(&R_mpi, &R_mpi, &M_mpi) == 0;
+        }
+        ok = ok && rsa_mpi_set_words(&Z_mpi, Z, words) && mbedtls_mpi_cmp_mpi(&Z_mpi, &R_mpi) == 0;
+        printf("Result check vs mbedtls: %s\n", ok ? "✓" : "MISMATCH");
+    }
+
+    bench_stats_t stats;
+    bench_stats_init(&stats);
+    size_t successful_ops = 0;
+    size_t hw_mults = 0;
+
+    for (size_t i = 0; i < iterations && ok; i++) {
+        generate_operand(X, bits);
+        generate_operand(Y, bits);
+
+        size_t mults_before = rsa_big_hw_mults();
+        uint64_t start = esp_timer_get_time();
+        bool success = E_words ? rsa_big_mod_exp(ctx, X, &plan, Z) : rsa_big_mod_mult(ctx, X, Y, Z);
+        uint64_t end = esp_timer_get_time();
+        hw_mults += rsa_big_hw_mults() - mults_before;
+
+        if (!success) {
+            printf("  Failed at iteration %zu\n", i);
+            break;
+        }
+        bench_stats_update(&stats, end - start);
+        successful_ops++;
+        bench_log_record(op_name, bits, exp_label, i + 1, end - start, NULL);
+    }
+
+    if (successful_ops > 0) {
+        double per_op = (double)hw_mults / (double)successful_ops;
+        printf("  Average: %.2f ms, %.1f hardware multiplies per op\n", bench_stats_avg(&stats) / 1000.0, per_op);
+        csv_summary(op_name, bits, exp_label, iterations, successful_ops, &stats);
+        csv_scale(bits, "karatsuba", op_name, exp_label, bench_stats_avg(&stats), per_op);
+    } else if (!ok) {
+        printf("Wide-modulus setup or check failed\n");
+    }
+
+    rsa_exp_plan_free(&plan);
+    mbedtls_mpi_free(&X_mpi);
+    mbedtls_mpi_free(&Y_mpi);
+    mbedtls_mpi_free(&M_mpi);
+    mbedtls_mpi_free(&R_mpi);
+    mbedtls_mpi_free(&Z_mpi);
+    heap_caps_free(X);
+    heap_caps_free(Y);
+    heap_caps_free(Z);
+}
+
+// mbedtls's pure-software exponentiation, where the build has one. With
+// the large-key fallback enabled the IDF port keeps the stock routine as
+// mbedtls_mpi_exp_mod_soft; on the linux target mbedtls_mpi_exp_mod is
+// itself the software one.
+#if CONFIG_IDF_TARGET_LINUX
+#define ENGINE_SW_EXP_MOD mbedtls_mpi_exp_mod
+#elif defined(MBEDTLS_MPI_EXP_MOD_ALT_FALLBACK)
+int mbedtls_mpi_exp_mod_soft(mbedtls_mpi *X, const mbedtls_mpi *A, const mbedtls_mpi *E,
+                             const mbedtls_mpi *N, mbedtls_mpi *prec_RR);
+#define ENGINE_SW_EXP_MOD mbedtls_mpi_exp_mod_soft
+#endif
+
+// One op on three engines, same operands each iteration: the context path,
+// stock mbedtls (hardware through the IDF port on chip) and pure-software
+// mbedtls for modexp when available. Every result is compared with the
+// others before the iteration counts. The mbedtls engines keep their R^2
+// mod M across calls, as the context does.
+static void benchmark_engines_op(const rsa_mont_ctx_t *ctx, const mbedtls_mpi *M_mpi, size_t bits,
+                                 size_t iterations, const uint32_t *E_words, const char *exp_label) {
+    size_t words = bits / 32;
+    const char *op = E_words ? "modexp" : "modmult";
+#ifdef ENGINE_SW_EXP_MOD
+    bool has_sw = E_words != NULL;
+#else
+    bool has_sw = false;
+#endif
+
+    uint32_t *X = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *Y = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    if (!X || !Y) {
+        printf("Memory allocation failed\n");
+        heap_caps_free(X);
+        heap_caps_free(Y);
+        return;
+    }
+
+    mbedtls_mpi X_mpi, Y_mpi, Z_mpi, R_mpi, S_mpi, RR_hw, RR_sw;
+    mbedtls_mpi_init(&X_mpi);
+    mbedtls_mpi_init(&Y_mpi);
+    mbedtls_mpi_init(&Z_mpi);
+    mbedtls_mpi_init(&R_mpi);
+    mbedtls_mpi_init(&S_mpi);
+    mbedtls_mpi_init(&RR_hw);
+    mbedtls_mpi_init(&RR_sw);
+    if (E_words) {
+        rsa_mpi_set_words(&Y_mpi, E_words, words);
+    }
+
+    printf("\n══════════════════════════════════════════\n");
+    printf("Engine Comparison (%zu-bit %s, %s exponent)\n", bits, op, exp_label);
+    printf("Engines: ctx, mbedtls%s\n", has_sw ? ", mbedtls software" : "");
+    printf("Iterations: %zu\n", iterations);
+    printf("══════════════════════════════════════════\n");
+
+    bench_stats_t ctx_stats, hw_stats, sw_stats;
+    bench_stats_init(&ctx_stats);
+    bench_stats_init(&hw_stats);
+    bench_stats_init(&sw_stats);
+    size_t matched = 0;
+
+    ops_reset();
+    // Iteration 0 is the warm-up: it sizes the outputs, fills the cached
+    // R^2 values and is checked like the rest, but not timed
+    for (size_t i = 0; i <= iterations; i++) {
+        generate_operand(X, bits);
+        rsa_mpi_set_words(&X_mpi, X, words);
+        if (!E_words) {
+            generate_operand(Y, bits);
+            rsa_mpi_set_words(&Y_mpi, Y, words);
+        }
+
+        if (i > 0) {
+            ops_begin();
+        }
+        uint64_t t0 = esp_timer_get_time();
+        bool ok = E_words ? rsa_mod_exp_hw_ctx(ctx, &X_mpi, &Y_mpi, &Z_mpi, false)
+                          : rsa_mod_mult_hw_ctx(ctx, &X_mpi, &Y_mpi, &Z_mpi);
+        uint64_t t1 = esp_timer_get_time();
+        if (i > 0) {
+            ops_end();
+        }
+        ok = ok && (E_words ? mbedtls_mpi_exp_mod(&R_mpi, &X_mpi, &Y_mpi, M_mpi, &RR_hw) == 0
+                            : mbedtls_mpi_mul_mpi(&R_mpi, &X_mpi, &Y_mpi) == 0 &&
+                                  mbedtls_mpi_mod_mpi(&R_mpi, &R_mpi, M_mpi) == 0);
+        uint64_t t2 = esp_timer_get_time();
+#ifdef ENGINE_SW_EXP_MOD
+        if (has_sw) {
+            ok = ok && ENGINE_SW_EXP_MOD(&S_mpi, &X_mpi, &Y_mpi, M_mpi, &RR_sw) == 0;
+        }
+#endif
+        uint64_t t3 = esp_timer_get_time();
+
+        if (!ok) {
+            printf("  Failed at iteration %zu\n", i);
+            break;
+        }
+        if (mbedtls_mpi_cmp_mpi(&Z_mpi, &R_mpi) != 0 || (has_sw && mbedtls_mpi_cmp_mpi(&Z_mpi, &S_mpi) != 0)) {
+            printf("  Result mismatch at iteration %zu\n", i);
+            break;
+        }
+        if (i == 0) {
+            continue;
+        }
+        bench_stats_update(&ctx_stats, t1 - t0);
+        bench_stats_update(&hw_stats, t2 - t1);
+        if (has_sw) {
+            bench_stats_update(&sw_stats, t3 - t2);
+        }
+        matched++;
+    }
+
+    if (matched > 0) {
+        char name[32];
+        double ctx_avg = bench_stats_avg(&ctx_stats);
+        double hw_avg = bench_stats_avg(&hw_stats);
+        snprintf(name, sizeof(name), "%s_ctx", op);
+        csv_summary(name, bits, exp_label, iterations, matched, &ctx_stats);
+        snprintf(name, sizeof(name), "%s_mbedtls", op);
+        csv_summary(name, bits, exp_label, iterations, matched, &hw_stats);
+        printf("  ctx %.2f µs, mbedtls %.2f µs (%.2fx)", ctx_avg, hw_avg, hw_avg / ctx_avg);
+        if (has_sw) {
+            double sw_avg = bench_stats_avg(&sw_stats);
+            snprintf(name, sizeof(name), "%s_mbedtls_sw", op);
+            csv_summary(name, bits, exp_label, iterations, matched, &sw_stats);
+            printf(", mbedtls software %.2f µs (%.2fx)\n", sw_avg, sw_avg / ctx_avg);
+            printf("CSV_SPEEDUP,%s,%zu,%s,%zu,%.2f,%.2f,%.2f,%.3f,%.3f\n", op, bits, exp_label, matched,
+                   ctx_avg, hw_avg, sw_avg, hw_avg / ctx_avg, sw_avg / ctx_avg);
+        } else {
+            printf("\n");
+            printf("CSV_SPEEDUP,%s,%zu,%s,%zu,%.2f,%.2f,na,%.3f,na\n", op, bits, exp_label, matched,
+                   ctx_avg, hw_avg, hw_avg / ctx_avg);
+        }
+    } else {
+        printf("No matching operations!\n");
+    }
+
+    mbedtls_mpi_free(&X_mpi);
+    mbedtls_mpi_free(&Y_mpi);
+    mbedtls_mpi_free(&Z_mpi);
+    mbedtls_mpi_free(&R_mpi);
+    mbedtls_mpi_free(&S_mpi);
+    mbedtls_mpi_free(&RR_hw);
+    mbedtls_mpi_free(&RR_sw);
+    heap_caps_free(X);
+    heap_caps_free(Y);
+}
+
+// Moduli past the accelerator's width run on the Karatsuba layer:
+// modmult and the small and full exponents
+static void benchmark_suite_big(size_t bits, size_t iter_mult, size_t iter_exp_small, size_t iter_exp_full) {
+    size_t words = bits / 32;
+
+    uint32_t *M = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *E = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    if (!M || !E) {
+        printf("Memory allocation failed\n");
+        heap_caps_free(M);
+        heap_caps_free(E);
+        return;
+    }
+
+    generate_modulus(M, bits);
+
+    printf("\n══════════════════════════════════════════\n");
+    printf("Fixed Modulus Setup (%zu-bit, wider than the accelerator)\n", bits);
+    printf("M: [0x%08" PRIX32 " ... 0x%08" PRIX32 "]\n", M[words - 1], M[0]);
+    printf("══════════════════════════════════════════\n");
+
+    rsa_big_ctx_t ctx;
+    uint64_t start = esp_timer_get_time();
+    if (!rsa_big_ctx_init(&ctx, M, words)) {
+        printf("Failed to initialize wide-modulus context\n");
+        heap_caps_free(M);
+        heap_caps_free(E);
+        return;
+    }
+    printf("Context init: %" PRIu64 " µs\n", esp_timer_get_time() - start);
+
+    uint32_t factors[5] = {0};
+    size_t factor_count = 0;
+    uint32_t small_exp = choose_small_exponent(factors, &factor_count);
+
+    benchmark_big_op(&ctx, bits, iter_mult, NULL, "na");
+    set_small_exponent(E, words, small_exp);
+    benchmark_big_op(&ctx, bits, iter_exp_small, E, "small");
+    if (iter_exp_full > 0) {
+        printf("Note: full-domain exponent timing can be very slow for %zu-bit.\n", bits);
+        set_full_exponent(E, bits);
+        benchmark_big_op(&ctx, bits, iter_exp_full, E, "full");
+    }
+
+    rsa_big_ctx_free(&ctx);
+    heap_caps_free(M);
+    heap_caps_free(E);
+}
+
+// iter_exp_variants drives the full-exponent benchmarks beyond the plain
+// modexp (async, fixed-base, multi-exp and CRT), which each run several
+// exponentiations per iteration; 0 skips them. The wide-modulus layer has
+// none of them.
+void benchmark_suite_fixed_mod(size_t bits, size_t iter_mult, size_t iter_exp_small, size_t iter_exp_full,
+                               size_t iter_exp_variants) {
+    size_t words = bits / 32;
+
+    if (words > RSA_4096_WORDS) {
+        benchmark_suite_big(bits, iter_mult, iter_exp_small, iter_exp_full);
+        return;
+    }
+
+    uint32_t *M = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *E_small = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *E_full = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+
+    if (!M || !E_small || !E_full) {
+        printf("Memory allocation failed\n");
+        return;
+    }
+
+    generate_modulus(M, bits);
+
+    printf("\n══════════════════════════════════════════\n");
+    printf("Fixed Modulus Setup (%zu-bit)\n", bits);
+    printf("M: [0x%08" PRIX32 " ... 0x%08" PRIX32 "]\n", M[words - 1], M[0]);
+    printf("══════════════════════════════════════════\n");
+
+    rsa_mont_ctx_t ctx;
+    if (!rsa_mont_ctx_init(&ctx, M, words)) {
+        printf("Failed to initialize Montgomery context\n");
+        heap_caps_free(M);
+        heap_caps_free(E_small);
+        heap_caps_free(E_full);
+        return;
+    }
+
+    uint32_t factors[5] = {0};
+    size_t factor_count = 0;
+    uint32_t small_exp = choose_small_exponent(factors, &factor_count);
+    set_small_exponent(E_small, words, small_exp);
+    set_full_exponent(E_full, bits);
+
+    printf("Small exponent target ~20000, chosen: %" PRIu32 " (product of %zu primes)\n", small_exp, factor_count);
+    if (factor_count > 0) {
+        printf("  Primes: ");
+        for (size_t i = 0; i < factor_count; i++) {
+            printf("%" PRIu32 "%s", factors[i], (i + 1 < factor_count) ? "*" : "\n");
+        }
+    }
+
+    printf("Full-domain exponent: %zu-bit random value\n", bits);
+
+    benchmark_ctx_init(M, bits, iter_mult);
+    benchmark_modmult_ctx(&ctx, bits, iter_mult);
+    benchmark_log_jitter_ctx(&ctx, bits, iter_mult);
+    benchmark_modmult_chain_ctx(&ctx, bits, iter_mult, 64);
+    benchmark_modmult_path_ctx(&ctx, bits, iter_mult);
+    benchmark_modexp_ctx(&ctx, bits, iter_exp_small, E_small, "small", false);
+    benchmark_batch_ctx(&ctx, bits, iter_exp_small, E_small, "small");
+    benchmark_batch_verify_ctx(&ctx, bits, iter_exp_small, small_exp);
+    benchmark_pipeline_ctx(&ctx, bits, iter_mult * PIPELINE_MULT_SCALE, NULL, "na");
+    benchmark_pipeline_ctx(&ctx, bits, iter_exp_small, E_small, "small");
+    benchmark_ctx_cache(bits, iter_mult);
+
+    if (iter_exp_full > 0) {
+        printf("Note: full-domain exponent timing can be very slow for %zu-bit.\n", bits);
+        benchmark_modexp_ctx(&ctx, bits, iter_exp_full, E_full, "full", true);
+    }
+    if (iter_exp_variants > 0) {
+        benchmark_async_ctx(&ctx, bits, iter_exp_variants, E_full, "full");
+        benchmark_fixedbase_ctx(&ctx, bits, iter_exp_variants);
+        benchmark_multiexp_ctx(&ctx, bits, iter_exp_variants);
+        benchmark_crt(bits, iter_exp_variants);
+    }
+
+    rsa_mont_ctx_free(&ctx);
+
+    heap_caps_free(M);
+    heap_caps_free(E_small);
+    heap_caps_free(E_full);
+}
+
+// Side-by-side timing of the context path against stock mbedtls on a
+// fresh bits-wide modulus: modmult, then the small and full exponents
+void benchmark_engines(size_t bits, size_t iter_mult, size_t iter_exp) {
+    size_t words = bits / 32;
+    if (bits % 32 != 0 || words == 0 || words > RSA_4096_WORDS) {
+        printf("Engine comparison: unsupported size %zu\n", bits);
+        return;
+    }
+
+    uint32_t *M = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *E = heap_caps_calloc(words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    if (!M || !E) {
+        printf("Memory allocation failed\n");
+        heap_caps_free(M);
+        heap_caps_free(E);
+        return;
+    }
+    generate_modulus(M, bits);
+
+    rsa_mont_ctx_t ctx;
+    if (!rsa_mont_ctx_init(&ctx, M, words)) {
+        printf("Failed to initialize Montgomery context\n");
+        heap_caps_free(M);
+        heap_caps_free(E);
+        return;
+    }
+    mbedtls_mpi M_mpi;
+    mbedtls_mpi_init(&M_mpi);
+    rsa_mpi_set_words(&M_mpi, M, words);
+
+    benchmark_engines_op(&ctx, &M_mpi, bits, iter_mult, NULL, "na");
+    set_small_exponent(E, words, choose_small_exponent(NULL, NULL));
+    benchmark_engines_op(&ctx, &M_mpi, bits, iter_exp, E, "small");
+    set_full_exponent(E, bits);
+    benchmark_engines_op(&ctx, &M_mpi, bits, iter_exp, E, "full");
+
+    mbedtls_mpi_free(&M_mpi);
+    rsa_mont_ctx_free(&ctx);
+    heap_caps_free(M);
+    heap_caps_free(E);
+}
+
+// Size sweep: every 256-bit step from 512 to 4096 bits, plus a few sizes
+// that are not whole words, each on its own modulus and context. The
+// accelerator runs on esp_mpi_hardware_words(words), so a size between two
+// hardware widths is padded up to the larger one.
+#define SWEEP_MIN_BITS 512
+#define SWEEP_STEP_BITS 256
+#define SWEEP_STEPPED ((RSA_4096_BITS - SWEEP_MIN_BITS) / SWEEP_STEP_BITS + 1)
+// 1000 bits keeps the word count of 1024; 2050 needs one word more than 2048
+static const size_t s_sweep_ragged_bits[] = {1000, 2050};
+#define SWEEP_RAGGED (sizeof(s_sweep_ragged_bits) / sizeof(s_sweep_ragged_bits[0]))
+#define SWEEP_POINTS (SWEEP_STEPPED + SWEEP_RAGGED)
+// A padded size is flagged when it costs at least this fraction of the
+// next size up
+#define SWEEP_PLATEAU_RATIO 0.95
+
+typedef struct {
+    size_t bits;
+    size_t hw_words;
+    double avg_us[2];    // modmult, small-exponent modexp
+    uint64_t min_us[2];
+    size_t success[2];
+} sweep_point_t;
+
+static const char *const s_sweep_ops[2] = {"modmult", "modexp"};
+static const char *const s_sweep_exp[2] = {"na", "small"};
+
+// Ascending sizes, so each point's plateau check looks at the next size up
+static void sweep_sizes(sweep_point_t *pts) {
+    for (size_t i = 0; i < SWEEP_STEPPED; i++) {
+        pts[i].bits = SWEEP_MIN_BITS + i * SWEEP_STEP_BITS;
+    }
+    for (size_t i = 0; i < SWEEP_RAGGED; i++) {
+        size_t j = SWEEP_STEPPED + i;
+        while (j > 0 && pts[j - 1].bits > s_sweep_ragged_bits[i]) {
+            pts[j].bits = pts[j - 1].bits;
+            j--;
+        }
+        pts[j].bits = s_sweep_ragged_bits[i];
+    }
+}
+
+static bool sweep_measure(sweep_point_t *pt, size_t iter_mult, size_t iter_exp, uint32_t small_exp,
+                          uint32_t *M, uint32_t *X, uint32_t *Y) {
+    size_t bits = pt->bits;
+    size_t words = (bits + 31) / 32;
+    generate_modulus(M, bits);
+
+    rsa_mont_ctx_t ctx;
+    if (!rsa_mont_ctx_init(&ctx, M, words)) {
+        return false;
+    }
+    pt->hw_words = ctx.hw_words;
+
+    mbedtls_mpi X_mpi, Y_mpi, E_mpi, Z_mpi, M_mpi, R_mpi;
+    mbedtls_mpi_init(&X_mpi);
+    mbedtls_mpi_init(&Y_mpi);
+    mbedtls_mpi_init(&E_mpi);
+    mbedtls_mpi_init(&Z_mpi);
+    mbedtls_mpi_init(&M_mpi);
+    mbedtls_mpi_init(&R_mpi);
+    bool ok = mbedtls_mpi_lset(&E_mpi, small_exp) == 0 && rsa_mpi_set_words(&M_mpi, M, words);
+
+    // Same addition chain as the suite's small-exponent modexp, so the
+    // rows line up with it
+    rsa_exp_plan_t plan;
+    memset(&plan, 0, sizeof(plan));
+    ok = ok && rsa_exp_plan_init_chain(&plan, small_exp);
+
+    for (int op = 0; op < 2 && ok; op++) {
+        size_t iterations = op ? iter_exp : iter_mult;
+        bench_stats_t stats;
+        bench_stats_init(&stats);
+        // Iteration 0 is the untimed warm-up and doubles as the
+        // correctness check
+        for (size_t i = 0; i <= iterations && ok; i++) {
+            generate_operand(X, bits);
+            generate_operand(Y, bits);
+            rsa_mpi_set_words(&X_mpi, X, words);
+            rsa_mpi_set_words(&Y_mpi, Y, words);
+            uint64_t start = esp_timer_get_time();
+            ok = op ? rsa_mod_exp_hw_plan(&ctx, &X_mpi, &plan, &Z_mpi, false)
+                    : rsa_mod_mult_hw_ctx(&ctx, &X_mpi, &Y_mpi, &Z_mpi);
+            uint64_t end = esp_timer_get_time();
+            if (ok && i == 0) {
+                ok = (op ? mbedtls_mpi_exp_mod(&R_mpi, &X_mpi, &E_mpi, &M_mpi, NULL) == 0
+                         : mbedtls_mpi_mul_mpi(&R_mpi, &X_mpi, &Y_mpi) == 0 &&
+                               mbedtls_mpi_mod_mpi(&R_mpi, &R_mpi, &M_mpi) == 0) &&
+                     mbedtls_mpi_cmp_mpi(&Z_mpi, &R_mpi) == 0;
+                if (!ok) {
+                    printf("  %zu-bit %s: result check vs mbedtls MISMATCH\n", bits, s_sweep_ops[op]);
+                }
+            } else if (ok) {
+                bench_stats_update(&stats, end - start);
+            }
+        }
+        pt->avg_us[op] = bench_stats_avg(&stats);
+        pt->min_us[op] = stats.min;
+        pt->success[op] = stats.count;
+    }
+
+    rsa_exp_plan_free(&plan);
+    mbedtls_mpi_free(&X_mpi);
+    mbedtls_mpi_free(&Y_mpi);
+    mbedtls_mpi_free(&E_mpi);
+    mbedtls_mpi_free(&Z_mpi);
+    mbedtls_mpi_free(&M_mpi);
+    mbedtls_mpi_free(&R_mpi);
+    rsa_mont_ctx_free(&ctx);
+    return ok;
+}
+
+// Scaling curve against hw_words, one CSV_SWEEP row per size and op. Rows
+// are printed once the whole sweep has run, since the plateau flag compares
+// each size with the next larger one.
+void benchmark_size_sweep(size_t iter_mult, size_t iter_exp) {
+    sweep_point_t *pts = heap_caps_calloc(SWEEP_POINTS, sizeof(sweep_point_t), MALLOC_CAP_DEFAULT);
+    uint32_t *M = heap_caps_calloc(RSA_4096_WORDS, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *X = heap_caps_calloc(RSA_4096_WORDS, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    uint32_t *Y = heap_caps_calloc(RSA_4096_WORDS, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    if (!pts || !M || !X || !Y) {
+        printf("Memory allocation failed\n");
+        heap_caps_free(pts);
+        heap_caps_free(M);
+        heap_caps_free(X);
+        heap_caps_free(Y);
+        return;
+    }
+
+    uint32_t small_exp = choose_small_exponent(NULL, NULL);
+    printf("\n══════════════════════════════════════════\n");
+    printf("Size Sweep (%d..%d bits, %d-bit steps, plus %zu ragged sizes)\n", SWEEP_MIN_BITS, RSA_4096_BITS,
+           SWEEP_STEP_BITS, (size_t)SWEEP_RAGGED);
+    printf("Iterations: modmult %zu, modexp %zu (exponent %" PRIu32 ")\n", iter_mult, iter_exp, small_exp);
+    printf("══════════════════════════════════════════\n");
+
+    sweep_sizes(pts);
+    size_t measured = 0;
+    for (size_t i = 0; i < SWEEP_POINTS; i++) {
+        if (!sweep_measure(&pts[i], iter_mult, iter_exp, small_exp, M, X, Y)) {
+            printf("  %zu-bit: failed\n", pts[i].bits);
+            break;
+        }
+        measured++;
+        printf("  %4zu-bit (hw_words %3zu): modmult %.2f µs, modexp %.2f µs\n",
+               pts[i].bits, pts[i].hw_words, pts[i].avg_us[0], pts[i].avg_us[1]);
+    }
+
+    for (size_t i = 0; i < measured; i++) {
+        const sweep_point_t *pt = &pts[i];
+        const sweep_point_t *next = (i + 1 < measured) ? &pts[i + 1] : NULL;
+        size_t pad_bits = pt->hw_words * 32 - pt->bits;
+        for (int op = 0; op < 2; op++) {
+            // Minimums rather than averages, so one preempted iteration
+            // does not raise a flag
+            bool plateau = next && pad_bits > 0 && next->min_us[op] > 0 &&
+                           (double)pt->min_us[op] >= SWEEP_PLATEAU_RATIO * (double)next->min_us[op];
+            if (plateau) {
+                printf("  %zu-bit %s costs %.0f%% of %zu-bit (padded by %zu bits)\n", pt->bits, s_sweep_ops[op],
+                       100.0 * (double)pt->min_us[op] / (double)next->min_us[op], next->bits, pad_bits);
+            }
+            printf("CSV_SWEEP,%s,%zu,%s,%zu,%zu,%zu,%zu,%.2f,%" PRIu64 ",%d\n", s_sweep_ops[op], pt->bits,
+                   s_sweep_exp[op], (pt->bits + 31) / 32, pt->hw_words, pad_bits, pt->success[op], pt->avg_us[op],
+                   pt->min_us[op], plateau ? 1 : 0);
+        }
+    }
+
+    heap_caps_free(pts);
+    heap_caps_free(M);
+    heap_caps_free(X);
+    heap_caps_free(Y);
 }
@@ -0,0 +1,303 @@
+#include "rsa_big.h"
+
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "rsa_hal.h"
+
+static size_t s_hw_mults;
+
+size_t rsa_big_hw_mults(void) {
+    return s_hw_mults;
+}
+
+// ==================== WORD ARITHMETIC ====================
+
+// Z[0..n) = A[0..n) + B[0..bn), bn <= n. Returns the carry out.
+static uint32_t big_add(uint32_t *Z, const uint32_t *A, size_t n, const uint32_t *B, size_t bn) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        carry += (uint64_t)A[i] + ((i < bn) ? B[i] : 0);
+        Z[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    return (uint32_t)carry;
+}
+
+// Z[0..n) -= B[0..bn), bn <= n. Returns the borrow out.
+static uint32_t big_sub_in(uint32_t *Z, size_t n, const uint32_t *B, size_t bn) {
+    uint32_t borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t d = (uint64_t)Z[i] - ((i < bn) ? B[i] : 0) - borrow;
+        Z[i] = (uint32_t)d;
+        borrow = (uint32_t)(d >> 63);
+        if (i >= bn && borrow == 0) {
+            break;
+        }
+    }
+    return borrow;
+}
+
+// Z[0..n) += B[0..bn), bn <= n. Returns the carry out.
+static uint32_t big_add_in(uint32_t *Z, size_t n, const uint32_t *B, size_t bn) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        carry += (uint64_t)Z[i] + ((i < bn) ? B[i] : 0);
+        Z[i] = (uint32_t)carry;
+        carry >>= 32;
+        if (i >= bn && carry == 0) {
+            break;
+        }
+    }
+    return (uint32_t)carry;
+}
+
+static int big_cmp(const uint32_t *A, const uint32_t *B, size_t n) {
+    for (size_t i = n; i-- > 0;) {
+        if (A[i] != B[i]) {
+            return (A[i] > B[i]) ? 1 : -1;
+        }
+    }
+    return 0;
+}
+
+// ==================== KARATSUBA ====================
+
+// Z[0..2n) = A * B on the accelerator's plain multiply mode (n <=
+// RSA_BIG_BASE_WORDS). X goes in the X block, Y in the upper half of the
+// Z block, and the product replaces the whole Z block. The lower half of
+// the Z block must be zero when the multiply starts; only the enable-time
+// memory clear guarantees that for the first product, and every later one
+// would find the previous product's low half there, so it is cleared here.
+static void big_mul_hw(const uint32_t *A, const uint32_t *B, size_t n, uint32_t *Z) {
+    size_t hw_words = esp_mpi_hardware_words(n);
+    mpi_hal_write_to_mem_block(MPI_PARAM_X, 0, A, n, hw_words);
+    mpi_hal_write_to_mem_block(MPI_PARAM_Z, 0, NULL, 0, hw_words);
+    mpi_hal_write_to_mem_block(MPI_PARAM_Z, hw_words * 4, B, n, hw_words);
+    mpi_hal_set_mode((hw_words * 2 / 16) + 7);
+    mpi_hal_start_op(MPI_MULT);
+    mpi_hal_read_result_hw_op(Z, 2 * n, 2 * n);
+    s_hw_mults++;
+}
+
+static size_t big_kara_scratch(size_t n) {
+    if (n <= RSA_BIG_BASE_WORDS) {
+        return 0;
+    }
+    size_t h = (n + 1) / 2;
+    return 4 * h + 2 + big_kara_scratch(h);
+}
+
+// Z[0..2n) = A * B with the peripheral enabled. Splits at h = ceil(n/2)
+// words: z0 = A0*B0, z2 = A1*B1 and (A0+A1)(B0+B1) - z0 - z2 for the middle.
+// The half sums carry one bit each, handled with adds so every recursive
+// product stays h words wide. tmp needs big_kara_scratch(n) words.
+static void big_mul(const uint32_t *A, const uint32_t *B, size_t n, uint32_t *Z, uint32_t *tmp) {
+    if (n <= RSA_BIG_BASE_WORDS) {
+        big_mul_hw(A, B, n, Z);
+        return;
+    }
+
+    const size_t h = (n + 1) / 2;
+    const size_t l = n - h;
+    uint32_t *sa = tmp;
+    uint32_t *sb = tmp + h;
+    uint32_t *mid = tmp + 2 * h;
+    uint32_t *next = mid + 2 * h + 2;
+
+    big_mul(A, B, h, Z, next);
+    big_mul(A + h, B + h, l, Z + 2 * h, next);
+
+    uint32_t ca = big_add(sa, A, h, A + h, l);
+    uint32_t cb = big_add(sb, B, h, B + h, l);
+    big_mul(sa, sb, h, mid, next);
+    mid[2 * h] = 0;
+    mid[2 * h + 1] = 0;
+    if (ca) {
+        big_add_in(mid + h, h + 2, sb, h);
+    }
+    if (cb) {
+        big_add_in(mid + h, h + 2, sa, h);
+    }
+    if (ca && cb) {
+        const uint32_t one = 1;
+        big_add_in(mid + 2 * h, 2, &one, 1);
+    }
+    big_sub_in(mid, 2 * h + 2, Z, 2 * h);
+    big_sub_in(mid, 2 * h + 2, Z + 2 * h, 2 * l);
+
+    // The middle term is below 2^(32(2h+1)), so any words past the end of Z
+    // are zero
+    size_t span = 2 * n - h;
+    big_add_in(Z + h, span, mid, (2 * h + 2 < span) ? 2 * h + 2 : span);
+}
+
+// ==================== MONTGOMERY LAYER ====================
+
+static uint32_t *big_reg(const rsa_big_ctx_t *ctx, size_t r) {
+    return &ctx->regs[r * ctx->words];
+}
+
+// Z = A * B * R^-1 mod M (REDC): T = A*B, m = (T mod R) * M' mod R,
+// (T + m*M) / R < 2M, then one conditional subtraction. Z may alias A or B.
+static void big_mont_mul(const rsa_big_ctx_t *ctx, const uint32_t *A, const uint32_t *B, uint32_t *Z) {
+    const size_t n = ctx->words;
+    uint32_t *T = ctx->prod;
+    uint32_t *U = T + 2 * n;
+    uint32_t *V = U + 2 * n;
+
+    big_mul(A, B, n, T, ctx->kara);
+    big_mul(T, ctx->Mprime, n, U, ctx->kara);
+    big_mul(U, ctx->M, n, V, ctx->kara);
+    uint32_t carry = big_add_in(T, 2 * n, V, 2 * n);
+
+    if (carry || big_cmp(T + n, ctx->M, n) >= 0) {
+        big_sub_in(T + n, n, ctx->M, n);
+    }
+    memcpy(Z, T + n, n * sizeof(uint32_t));
+}
+
+bool rsa_big_ctx_init(rsa_big_ctx_t *ctx, const uint32_t *M_words, size_t words) {
+    if (!ctx || !M_words || words == 0 || (M_words[0] & 1u) == 0) {
+        return false;
+    }
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->words = words;
+
+    size_t window = rsa_exp_window_size(words * 32);
+    size_t regs = (size_t)1 << (window - 1);
+    if (regs < RSA_EXP_CHAIN_REGS) {
+        regs = RSA_EXP_CHAIN_REGS;
+    }
+    ctx->scratch_regs = regs;
+
+    // M, M', R^2, one, the registers, three 2n-word products, Karatsuba
+    size_t total = words * (4 + regs + 2 + 6) + big_kara_scratch(words);
+    ctx->mem = heap_caps_calloc(total, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    if (!ctx->mem) {
+        return false;
+    }
+    ctx->M = ctx->mem;
+    ctx->Mprime = ctx->M + words;
+    ctx->RR = ctx->Mprime + words;
+    ctx->one = ctx->RR + words;
+    ctx->regs = ctx->one + words;
+    ctx->prod = ctx->regs + (regs + 2) * words;
+    ctx->kara = ctx->prod + 6 * words;
+
+    memcpy(ctx->M, M_words, words * sizeof(uint32_t));
+    ctx->one[0] = 1;
+
+    // One-time constants in software: M' = R - M^-1 mod R, R^2 mod M
+    mbedtls_mpi M, R, T;
+    mbedtls_mpi_init(&M);
+    mbedtls_mpi_init(&R);
+    mbedtls_mpi_init(&T);
+    bool ok = rsa_mpi_set_words(&M, M_words, words) &&
+              mbedtls_mpi_lset(&R, 1) == 0 &&
+              mbedtls_mpi_shift_l(&R, words * 32) == 0 &&
+              mbedtls_mpi_inv_mod(&T, &M, &R) == 0 &&
+              mbedtls_mpi_sub_mpi(&T, &R, &T) == 0;
+    if (ok) {
+        rsa_mpi_get_words(&T, ctx->Mprime, words);
+        ok = mbedtls_mpi_lset(&T, 1) == 0 &&
+             mbedtls_mpi_shift_l(&T, words * 64) == 0 &&
+             mbedtls_mpi_mod_mpi(&T, &T, &M) == 0;
+    }
+    if (ok) {
+        rsa_mpi_get_words(&T, ctx->RR, words);
+    }
+    mbedtls_mpi_free(&M);
+    mbedtls_mpi_free(&R);
+    mbedtls_mpi_free(&T);
+
+    if (!ok) {
+        rsa_big_ctx_free(ctx);
+    }
+    return ok;
+}
+
+void rsa_big_ctx_free(rsa_big_ctx_t *ctx) {
+    if (!ctx) {
+        return;
+    }
+    heap_caps_free(ctx->mem);
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+bool rsa_big_mul(const rsa_big_ctx_t *ctx, const uint32_t *A, const uint32_t *B, uint32_t *Z) {
+    if (!ctx || !ctx->mem || !A || !B || !Z) {
+        return false;
+    }
+    esp_mpi_enable_hardware_hw_op();
+    big_mul(A, B, ctx->words, Z, ctx->kara);
+    esp_mpi_disable_hardware_hw_op();
+    return true;
+}
+
+bool rsa_big_mod_mult(const rsa_big_ctx_t *ctx, const uint32_t *X, const uint32_t *Y, uint32_t *Z) {
+    if (!ctx || !ctx->mem || !X || !Y || !Z) {
+        return false;
+    }
+    uint32_t *acc = big_reg(ctx, ctx->scratch_regs + 1);
+    esp_mpi_enable_hardware_hw_op();
+    // mont(X, R^2) = X * R, then mont(X * R, Y) = X * Y
+    big_mont_mul(ctx, X, ctx->RR, acc);
+    big_mont_mul(ctx, acc, Y, Z);
+    esp_mpi_disable_hardware_hw_op();
+    return true;
+}
+
+// Same schedule as exp_body_locked in rsa_hw.c, on word registers
+bool rsa_big_mod_exp(const rsa_big_ctx_t *ctx, const uint32_t *X, const rsa_exp_plan_t *plan, uint32_t *Z) {
+    if (!ctx || !ctx->mem || !X || !plan || !Z) {
+        return false;
+    }
+    const size_t n = ctx->words;
+    if (!plan->is_chain && plan->step_count == 0) {
+        memset(Z, 0, n * sizeof(uint32_t));
+        Z[0] = 1;
+        return true;
+    }
+    if (!plan->is_chain && plan->table_size > ctx->scratch_regs) {
+        return false;
+    }
+
+    uint32_t *X2 = big_reg(ctx, ctx->scratch_regs);
+    uint32_t *acc = big_reg(ctx, ctx->scratch_regs + 1);
+    const uint32_t *result = acc;
+
+    esp_mpi_enable_hardware_hw_op();
+    big_mont_mul(ctx, X, ctx->RR, big_reg(ctx, 0));
+
+    if (plan->is_chain) {
+        for (size_t i = 0; i < plan->op_count; i++) {
+            const rsa_exp_op_t *op = &plan->ops[i];
+            big_mont_mul(ctx, big_reg(ctx, op->a), big_reg(ctx, op->b), big_reg(ctx, op->dst));
+        }
+        result = big_reg(ctx, (plan->op_count > 0) ? plan->result_reg : 0);
+    } else {
+        // regs[k] = X^(2k+1) in Montgomery form
+        if (plan->table_size > 1) {
+            big_mont_mul(ctx, big_reg(ctx, 0), big_reg(ctx, 0), X2);
+            for (size_t k = 1; k < plan->table_size; k++) {
+                big_mont_mul(ctx, big_reg(ctx, k - 1), X2, big_reg(ctx, k));
+            }
+        }
+        memcpy(acc, big_reg(ctx, plan->steps[0].digit >> 1), n * sizeof(uint32_t));
+        for (size_t i = 1; i < plan->step_count; i++) {
+            const rsa_exp_step_t *step = &plan->steps[i];
+            for (uint16_t k = 0; k < step->squarings; k++) {
+                big_mont_mul(ctx, acc, acc, acc);
+            }
+            big_mont_mul(ctx, acc, big_reg(ctx, step->digit >> 1), acc);
+        }
+        for (size_t k = 0; k < plan->tail_squarings; k++) {
+            big_mont_mul(ctx, acc, acc, acc);
+        }
+    }
+
+    big_mont_mul(ctx, result, ctx->one, Z);
+    esp_mpi_disable_hardware_hw_op();
+    return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "rsa_hw.h"
+
+// Modular arithmetic for moduli wider than the accelerator (6144, 8192
+// bits, ...). Products are Karatsuba splits down to the peripheral's plain
+// multiply mode, whose operands top out at RSA_BIG_BASE_WORDS, and each
+// montmul is a software REDC over three such products. Operands use the
+// zero-copy word layout (ctx->words little-endian words, value < M).
+#define RSA_BIG_BASE_WORDS (RSA_4096_WORDS / 2)
+
+// Per-modulus context. Like rsa_mont_ctx_t, init allocates the exponent
+// table, REDC products and Karatsuba temporaries in one block, so
+// steady-state mult/exp make no heap calls; one task at a time.
+typedef struct {
+    size_t words;
+    uint32_t *M;
+    uint32_t *Mprime;            // -M^-1 mod R, R = 2^(32 * words)
+    uint32_t *RR;                // R^2 mod M
+    uint32_t *one;
+    uint32_t *regs;              // scratch_regs table entries, then X^2 and acc
+    size_t scratch_regs;
+    uint32_t *prod;              // three double-width products for REDC
+    uint32_t *kara;
+    uint32_t *mem;               // owns everything above
+} rsa_big_ctx_t;
+
+bool rsa_big_ctx_init(rsa_big_ctx_t *ctx, const uint32_t *M_words, size_t words);
+void rsa_big_ctx_free(rsa_big_ctx_t *ctx);
+
+// Z (2 * ctx->words words) = A * B, no reduction
+bool rsa_big_mul(const rsa_big_ctx_t *ctx, const uint32_t *A, const uint32_t *B, uint32_t *Z);
+bool rsa_big_mod_mult(const rsa_big_ctx_t *ctx, const uint32_t *X, const uint32_t *Y, uint32_t *Z);
+// Takes the same plans as rsa_mod_exp_hw_plan; window plans must fit the
+// context's table (any plan built with window 0 for a modulus-sized
+// exponent does).
+bool rsa_big_mod_exp(const rsa_big_ctx_t *ctx, const uint32_t *X, const rsa_exp_plan_t *plan, uint32_t *Z);
+
+// Plain hardware multiplies issued so far, for op-count reporting
+size_t rsa_big_hw_mults(void);
@@ -0,0 +1,85 @@
+#include "rsa_ctx_cache.h"
+
+#include <string.h>
+
+#include "esp_heap_caps.h"
+
+// FNV-1a over the modulus words, with the length mixed in first
+uint64_t rsa_modulus_fingerprint(const uint32_t *M_words, size_t words) {
+    uint64_t h = 0xcbf29ce484222325ull ^ (uint64_t)words;
+    for (size_t i = 0; i < words; i++) {
+        h = (h ^ M_words[i]) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+bool rsa_ctx_cache_init(rsa_ctx_cache_t *cache, size_t capacity) {
+    if (!cache || capacity == 0) {
+        return false;
+    }
+    memset(cache, 0, sizeof(*cache));
+    cache->entries = heap_caps_calloc(capacity, sizeof(rsa_ctx_cache_entry_t), MALLOC_CAP_DEFAULT);
+    if (!cache->entries) {
+        return false;
+    }
+    cache->capacity = capacity;
+    return true;
+}
+
+void rsa_ctx_cache_free(rsa_ctx_cache_t *cache) {
+    if (!cache || !cache->entries) {
+        return;
+    }
+    for (size_t i = 0; i < cache->capacity; i++) {
+        if (cache->entries[i].used) {
+            rsa_mont_ctx_free(&cache->entries[i].ctx);
+        }
+    }
+    heap_caps_free(cache->entries);
+    cache->entries = NULL;
+    cache->capacity = 0;
+}
+
+static bool ctx_cache_matches(const rsa_ctx_cache_entry_t *e, uint64_t fp,
+                              const uint32_t *M_words, size_t words) {
+    if (!e->used || e->fingerprint != fp || e->ctx.words != words) {
+        return false;
+    }
+    // M is stored with exactly `words` limbs by rsa_mpi_set_words
+    return memcmp(e->ctx.M.MBEDTLS_PRIVATE(p), M_words, words * sizeof(uint32_t)) == 0;
+}
+
+const rsa_mont_ctx_t *rsa_ctx_cache_get(rsa_ctx_cache_t *cache, const uint32_t *M_words, size_t words) {
+    if (!cache || !cache->entries || !M_words || words == 0) {
+        return NULL;
+    }
+
+    uint64_t fp = rsa_modulus_fingerprint(M_words, words);
+    rsa_ctx_cache_entry_t *victim = NULL;
+    for (size_t i = 0; i < cache->capacity; i++) {
+        rsa_ctx_cache_entry_t *e = &cache->entries[i];
+        if (ctx_cache_matches(e, fp, M_words, words)) {
+            e->last_use = ++cache->clock;
+            cache->hits++;
+            return &e->ctx;
+        }
+        // Free slots first, then the oldest use
+        if (!victim || (victim->used && (!e->used || e->last_use < victim->last_use))) {
+            victim = e;
+        }
+    }
+
+    cache->misses++;
+    if (victim->used) {
+        rsa_mont_ctx_free(&victim->ctx);
+        victim->used = false;
+        cache->evictions++;
+    }
+    if (!rsa_mont_ctx_init(&victim->ctx, M_words, words)) {
+        return NULL;
+    }
+    victim->fingerprint = fp;
+    victim->last_use = ++cache->clock;
+    victim->used = true;
+    return &victim->ctx;
+}
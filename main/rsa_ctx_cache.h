@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "rsa_hw.h"
+
+// Bounded LRU cache of Montgomery contexts for workloads that rotate among
+// several moduli. Entries are keyed by a 64-bit fingerprint of the modulus
+// words and confirmed by a full compare, so a hit skips the software
+// R^2 mod M reduction and the arena allocation of rsa_mont_ctx_init.
+typedef struct {
+    uint64_t fingerprint;
+    uint32_t last_use;
+    bool used;
+    rsa_mont_ctx_t ctx;
+} rsa_ctx_cache_entry_t;
+
+typedef struct {
+    rsa_ctx_cache_entry_t *entries;
+    size_t capacity;
+    uint32_t clock;
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+} rsa_ctx_cache_t;
+
+bool rsa_ctx_cache_init(rsa_ctx_cache_t *cache, size_t capacity);
+void rsa_ctx_cache_free(rsa_ctx_cache_t *cache);
+// Returns the context for M, building it on a miss and evicting the least
+// recently used entry when full. The pointer stays valid until a later get
+// evicts it. NULL if the context cannot be built.
+const rsa_mont_ctx_t *rsa_ctx_cache_get(rsa_ctx_cache_t *cache, const uint32_t *M_words, size_t words);
+
+uint64_t rsa_modulus_fingerprint(const uint32_t *M_words, size_t words);
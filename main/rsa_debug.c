@@ -5,12 +5,11 @@
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "soc/dport_reg.h"
 #include "esp_log.h"
 #include "esp_random.h"
+#include "esp_heap_caps.h"
 #include "mbedtls/bignum.h"
-#include "bignum_impl.h"
-#include "hal/mpi_hal.h"
+#include "rsa_hal.h"
 
 static const char* TAG = "RSA_DEBUG";
 
@@ -282,6 +281,87 @@ bool verify_hw_sw_small_exp(size_t iterations) {
     return true;
 }
 
+// Full-size differential check of the context path. Each iteration draws
+// a bits-wide odd modulus with the top bit set, operands below it and a
+// full-width exponent, and compares rsa_mod_mult_hw_ctx and
+// rsa_mod_exp_hw_ctx with mbedtls bit for bit.
+bool verify_hw_sw_full(size_t bits, size_t iterations) {
+    printf("\n[CHECK] Full-size %zu-bit ctx mod-mult / mod-exp vs mbedtls:\n", bits);
+
+    size_t words = bits / 32;
+    if (bits % 32 != 0 || words == 0 || words > RSA_4096_WORDS) {
+        printf("  ✗ Unsupported size\n");
+        return false;
+    }
+
+    uint32_t *buf = heap_caps_calloc(4 * words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    if (!buf) {
+        printf("  ✗ Memory allocation failed\n");
+        return false;
+    }
+    uint32_t *M = buf;
+    uint32_t *X = buf + words;
+    uint32_t *Y = buf + 2 * words;
+    uint32_t *E = buf + 3 * words;
+
+    mbedtls_mpi X_mpi, Y_mpi, E_mpi, M_mpi, Z_mpi, R_mpi;
+    mbedtls_mpi_init(&X_mpi);
+    mbedtls_mpi_init(&Y_mpi);
+    mbedtls_mpi_init(&E_mpi);
+    mbedtls_mpi_init(&M_mpi);
+    mbedtls_mpi_init(&Z_mpi);
+    mbedtls_mpi_init(&R_mpi);
+
+    bool ok = true;
+    for (size_t i = 0; i < iterations && ok; i++) {
+        esp_fill_random(buf, 4 * words * sizeof(uint32_t));
+        M[words - 1] |= 0x80000000u;
+        M[0] |= 1u;
+        X[words - 1] &= 0x7FFFFFFFu;
+        Y[words - 1] &= 0x7FFFFFFFu;
+        E[words - 1] |= 0x80000000u;
+
+        rsa_mont_ctx_t ctx;
+        if (!rsa_mont_ctx_init(&ctx, M, words)) {
+            printf("  ✗ Context init failed at iter %zu\n", i);
+            ok = false;
+            break;
+        }
+        ok = rsa_mpi_set_words(&X_mpi, X, words) && rsa_mpi_set_words(&Y_mpi, Y, words) &&
+             rsa_mpi_set_words(&E_mpi, E, words) && rsa_mpi_set_words(&M_mpi, M, words);
+
+        if (ok && (!rsa_mod_mult_hw_ctx(&ctx, &X_mpi, &Y_mpi, &Z_mpi) ||
+                   mbedtls_mpi_mul_mpi(&R_mpi, &X_mpi, &Y_mpi) != 0 ||
+                   mbedtls_mpi_mod_mpi(&R_mpi, &R_mpi, &M_mpi) != 0 ||
+                   mbedtls_mpi_cmp_mpi(&Z_mpi, &R_mpi) != 0)) {
+            printf("  ✗ Mod-mult mismatch at iter %zu\n", i);
+            ok = false;
+        }
+        if (ok && (!rsa_mod_exp_hw_ctx(&ctx, &X_mpi, &E_mpi, &Z_mpi, true) ||
+                   mbedtls_mpi_exp_mod(&R_mpi, &X_mpi, &E_mpi, &M_mpi, NULL) != 0 ||
+                   mbedtls_mpi_cmp_mpi(&Z_mpi, &R_mpi) != 0)) {
+            printf("  ✗ Mod-exp mismatch at iter %zu\n", i);
+            ok = false;
+        }
+        rsa_mont_ctx_free(&ctx);
+        // Let the idle task run between the long 4096-bit exponentiations
+        vTaskDelay(1);
+    }
+
+    if (ok) {
+        printf("  ✓ %zu/%zu passed\n", iterations, iterations);
+    }
+
+    mbedtls_mpi_free(&X_mpi);
+    mbedtls_mpi_free(&Y_mpi);
+    mbedtls_mpi_free(&E_mpi);
+    mbedtls_mpi_free(&M_mpi);
+    mbedtls_mpi_free(&Z_mpi);
+    mbedtls_mpi_free(&R_mpi);
+    heap_caps_free(buf);
+    return ok;
+}
+
 // Simple test to debug hardware issues
 void debug_simple_hardware_test(void) {
     printf("\n[DEBUG] Simple Hardware Test:\n");
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "sdkconfig.h"
+
+// Accelerator surface the RSA code is written against: the mbedtls port
+// and mpi HAL on chip, the software model in rsa_hal_model.c on the linux
+// target.
+#if CONFIG_IDF_TARGET_LINUX
+#include "rsa_hal_model.h"
+#else
+#include "esp_intr_alloc.h"
+#include "soc/periph_defs.h"
+#include "soc/dport_reg.h"
+#include "soc/hwcrypto_reg.h"
+#include "bignum_impl.h"
+#include "hal/mpi_hal.h"
+#endif
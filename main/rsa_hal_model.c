@@ -0,0 +1,341 @@
+#include "rsa_hal_model.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(sizeof(mbedtls_mpi_uint) == sizeof(uint32_t),
+               "the RSA code and the model assume 32-bit mpi limbs (linux target builds with -m32)");
+
+volatile uint32_t rsa_model_mem[4][RSA_MODEL_BLOCK_WORDS];
+rsa_model_regs_t rsa_model_regs = { .query_clean = 1 };
+
+static bool s_enabled;
+static bool s_int_enabled;
+static bool s_started;
+static intr_handler_t s_isr;
+static void *s_isr_arg;
+static rsa_model_counters_t s_counters;
+
+static void model_fault(const char *what) {
+    fprintf(stderr, "rsa_hal_model: %s\n", what);
+    abort();
+}
+
+void rsa_model_get_counters(rsa_model_counters_t *out) {
+    *out = s_counters;
+}
+
+void rsa_model_reset_counters(void) {
+    memset(&s_counters, 0, sizeof(s_counters));
+}
+
+// ==================== ARITHMETIC ====================
+
+static void block_load(uint32_t *dst, volatile const uint32_t *src, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = src[i];
+    }
+}
+
+// t[0..n] -= m[0..n-1]
+static void model_sub(uint32_t *t, const uint32_t *m, size_t n) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t d = (uint64_t)t[i] - m[i] - borrow;
+        t[i] = (uint32_t)d;
+        borrow = (d >> 32) & 1;
+    }
+    t[n] -= (uint32_t)borrow;
+}
+
+// Word-serial CIOS: one multiply row and one reduction row per word of Y,
+// using the M' from the register rather than one derived from M
+static void model_montmul(size_t n) {
+    uint32_t x[RSA_MODEL_BLOCK_WORDS], y[RSA_MODEL_BLOCK_WORDS], m[RSA_MODEL_BLOCK_WORDS];
+    uint32_t t[RSA_MODEL_BLOCK_WORDS + 2] = {0};
+    uint32_t mprime = rsa_model_regs.m_dash;
+    block_load(x, rsa_model_mem[MPI_PARAM_X], n);
+    block_load(y, rsa_model_mem[MPI_PARAM_Z], n);
+    block_load(m, rsa_model_mem[MPI_PARAM_M], n);
+
+    if ((m[0] & 1) == 0) {
+        model_fault("even modulus");
+    }
+    if ((uint32_t)(m[0] * mprime) != UINT32_MAX) {
+        model_fault("M' does not match M");
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        uint64_t c = 0;
+        for (size_t j = 0; j < n; j++) {
+            uint64_t s = (uint64_t)x[j] * y[i] + t[j] + c;
+            t[j] = (uint32_t)s;
+            c = s >> 32;
+        }
+        uint64_t s = (uint64_t)t[n] + c;
+        t[n] = (uint32_t)s;
+        t[n + 1] = (uint32_t)(s >> 32);
+
+        uint32_t u = t[0] * mprime;
+        s = (uint64_t)u * m[0] + t[0];
+        c = s >> 32;
+        for (size_t j = 1; j < n; j++) {
+            s = (uint64_t)u * m[j] + t[j] + c;
+            t[j - 1] = (uint32_t)s;
+            c = s >> 32;
+        }
+        s = (uint64_t)t[n] + c;
+        t[n - 1] = (uint32_t)s;
+        t[n] = t[n + 1] + (uint32_t)(s >> 32);
+    }
+
+    // t < 2M for operands below M, and like the chip the model leaves it
+    // there: callers do the final subtraction. Only a t that needs bit
+    // 32 * n, which the block cannot hold, comes back reduced.
+    if (t[n] != 0) {
+        model_sub(t, m, n);
+    }
+    for (size_t i = 0; i < n; i++) {
+        rsa_model_mem[MPI_PARAM_Z][i] = t[i];
+    }
+    s_counters.montmul++;
+}
+
+// The whole Z block takes part: Y is its upper half, and the product is
+// accumulated onto the lower half rather than onto zero. Callers have to
+// clear that half before every multiply, as the chip requires; a stale
+// low half left by the previous product shows up as a wrong result here.
+static void model_plainmul(size_t n) {
+    uint32_t x[RSA_MODEL_BLOCK_WORDS / 2], y[RSA_MODEL_BLOCK_WORDS / 2];
+    uint32_t z[RSA_MODEL_BLOCK_WORDS] = {0};
+    block_load(x, rsa_model_mem[MPI_PARAM_X], n);
+    block_load(y, rsa_model_mem[MPI_PARAM_Z] + n, n);
+    block_load(z, rsa_model_mem[MPI_PARAM_Z], n);
+
+    for (size_t i = 0; i < n; i++) {
+        uint64_t c = 0;
+        for (size_t j = 0; j < n; j++) {
+            uint64_t s = (uint64_t)x[j] * y[i] + z[i + j] + c;
+            z[i + j] = (uint32_t)s;
+            c = s >> 32;
+        }
+        z[i + n] = (uint32_t)c;
+    }
+    for (size_t i = 0; i < 2 * n; i++) {
+        rsa_model_mem[MPI_PARAM_Z][i] = z[i];
+    }
+    s_counters.plainmul++;
+}
+
+// ==================== MPI HAL ====================
+
+size_t mpi_hal_calc_hardware_words(size_t words) {
+    return (words + 0xF) & ~(size_t)0xF;
+}
+
+void mpi_hal_enable_hardware_hw_op(void) {
+    if (s_enabled) {
+        model_fault("enabled twice");
+    }
+    s_enabled = true;
+    // Taking the peripheral out of reset clears its memory
+    for (size_t b = 0; b < 4; b++) {
+        for (size_t i = 0; i < RSA_MODEL_BLOCK_WORDS; i++) {
+            rsa_model_mem[b][i] = 0;
+        }
+    }
+}
+
+void mpi_hal_disable_hardware_hw_op(void) {
+    if (!s_enabled) {
+        model_fault("disabled while not enabled");
+    }
+    s_enabled = false;
+}
+
+void mpi_hal_interrupt_enable(bool enable) {
+    s_int_enabled = enable;
+}
+
+void mpi_hal_clear_interrupt(void) {
+    rsa_model_regs.interrupt = 0;
+}
+
+void mpi_hal_set_mode(const size_t num_words) {
+    rsa_model_regs.mult_mode = (uint32_t)num_words;
+}
+
+void mpi_hal_write_to_mem_block(mpi_param_t param, size_t offset, const uint32_t *p, size_t n, size_t num_words) {
+    if (!s_enabled) {
+        model_fault("memory write while disabled");
+    }
+    if (offset / 4 + num_words > RSA_MODEL_BLOCK_WORDS) {
+        model_fault("memory write past the end of a block");
+    }
+    volatile uint32_t *block = rsa_model_mem[param] + offset / 4;
+    size_t copy = (n < num_words) ? n : num_words;
+    for (size_t i = 0; i < copy; i++) {
+        block[i] = p[i];
+    }
+    for (size_t i = copy; i < num_words; i++) {
+        block[i] = 0;
+    }
+    s_counters.words_written += num_words;
+}
+
+void mpi_hal_write_at_offset(mpi_param_t param, int offset, uint32_t value) {
+    if (!s_enabled) {
+        model_fault("memory write while disabled");
+    }
+    if (offset < 0 || (size_t)offset / 4 >= RSA_MODEL_BLOCK_WORDS) {
+        model_fault("memory write past the end of a block");
+    }
+    rsa_model_mem[param][offset / 4] = value;
+    s_counters.words_written++;
+}
+
+void mpi_hal_write_m_prime(uint32_t Mprime) {
+    rsa_model_regs.m_dash = Mprime;
+}
+
+void mpi_hal_write_rinv(uint32_t rinv) {
+    (void)rinv;
+}
+
+void mpi_hal_start_op(mpi_op_t op) {
+    if (!s_enabled) {
+        model_fault("operation started while disabled");
+    }
+    if (op != MPI_MULT) {
+        model_fault("only MPI_MULT is modelled");
+    }
+
+    uint32_t mode = rsa_model_regs.mult_mode;
+    if (mode < 8) {
+        model_montmul(((size_t)mode + 1) * 16);
+    } else if (mode < 16) {
+        model_plainmul(((size_t)mode - 7) * 16 / 2);
+    } else {
+        model_fault("invalid multiplication mode");
+    }
+    rsa_model_regs.mult_start = 1;
+    rsa_model_regs.interrupt = 1;
+    s_started = true;
+
+    // Deliver the completion interrupt. An op started from inside the
+    // handler is delivered by this loop instead of recursing, as the next
+    // interrupt would only be taken after the handler returns.
+    static bool in_isr;
+    static bool pending;
+    if (!s_int_enabled || !s_isr) {
+        return;
+    }
+    if (in_isr) {
+        pending = true;
+        return;
+    }
+    do {
+        pending = false;
+        in_isr = true;
+        s_counters.interrupts++;
+        s_isr(s_isr_arg);
+        in_isr = false;
+    } while (pending);
+}
+
+void mpi_hal_wait_op_complete(void) {
+    if (!s_started || rsa_model_regs.interrupt == 0) {
+        model_fault("waiting with no operation pending");
+    }
+    mpi_hal_clear_interrupt();
+}
+
+void mpi_hal_read_result_hw_op(uint32_t *p, size_t n, size_t z_words) {
+    mpi_hal_wait_op_complete();
+    for (size_t i = 0; i < z_words && i < n; i++) {
+        p[i] = rsa_model_mem[MPI_PARAM_Z][i];
+    }
+    for (size_t i = z_words; i < n; i++) {
+        p[i] = 0;
+    }
+    s_counters.words_read += z_words;
+}
+
+esp_err_t esp_intr_alloc(int source, int flags, intr_handler_t handler, void *arg, intr_handle_t *ret_handle) {
+    (void)flags;
+    if (source != ETS_RSA_INTR_SOURCE || !handler) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    s_isr = handler;
+    s_isr_arg = arg;
+    if (ret_handle) {
+        *ret_handle = (intr_handle_t)&s_isr;
+    }
+    return ESP_OK;
+}
+
+// ==================== MBEDTLS PORT ====================
+
+size_t esp_mpi_hardware_words(size_t words) {
+    return mpi_hal_calc_hardware_words(words);
+}
+
+void esp_mpi_enable_hardware_hw_op(void) {
+    mpi_hal_enable_hardware_hw_op();
+    s_counters.enables++;
+}
+
+void esp_mpi_disable_hardware_hw_op(void) {
+    mpi_hal_disable_hardware_hw_op();
+}
+
+void esp_mpi_mul_mpi_mod_hw_op(const mbedtls_mpi *X, const mbedtls_mpi *Y, const mbedtls_mpi *M,
+                               const mbedtls_mpi *Rinv, mbedtls_mpi_uint Mprime, size_t hw_words) {
+    // X * R^2 * R^-1 = X * R first, then (X * R) * Y * R^-1 = X * Y mod M,
+    // left in Z for the caller to read
+    mpi_hal_write_to_mem_block(MPI_PARAM_M, 0, M->MBEDTLS_PRIVATE(p), M->MBEDTLS_PRIVATE(n), hw_words);
+    mpi_hal_write_to_mem_block(MPI_PARAM_X, 0, X->MBEDTLS_PRIVATE(p), X->MBEDTLS_PRIVATE(n), hw_words);
+    mpi_hal_write_to_mem_block(MPI_PARAM_Z, 0, Rinv->MBEDTLS_PRIVATE(p), Rinv->MBEDTLS_PRIVATE(n), hw_words);
+    mpi_hal_write_m_prime(Mprime);
+    mpi_hal_set_mode((hw_words / 16) - 1);
+    mpi_hal_start_op(MPI_MULT);
+    mpi_hal_wait_op_complete();
+    mpi_hal_write_to_mem_block(MPI_PARAM_X, 0, Y->MBEDTLS_PRIVATE(p), Y->MBEDTLS_PRIVATE(n), hw_words);
+    mpi_hal_start_op(MPI_MULT);
+    s_counters.mul_mod_hw_op++;
+}
+
+void esp_mpi_mul_mpi_hw_op(const mbedtls_mpi *X, const mbedtls_mpi *Y, size_t num_words) {
+    mpi_hal_write_to_mem_block(MPI_PARAM_X, 0, X->MBEDTLS_PRIVATE(p), X->MBEDTLS_PRIVATE(n), num_words);
+    mpi_hal_write_to_mem_block(MPI_PARAM_Z, num_words * 4, Y->MBEDTLS_PRIVATE(p), Y->MBEDTLS_PRIVATE(n), num_words);
+    mpi_hal_set_mode(((num_words * 2) / 16) + 7);
+    mpi_hal_start_op(MPI_MULT);
+}
+
+int esp_mont_hw_op(mbedtls_mpi *Z, const mbedtls_mpi *X, const mbedtls_mpi *Y, const mbedtls_mpi *M,
+                   mbedtls_mpi_uint Mprime, size_t hw_words, bool again) {
+    int ret = 0;
+    if (!again) {
+        mpi_hal_write_to_mem_block(MPI_PARAM_M, 0, M->MBEDTLS_PRIVATE(p), M->MBEDTLS_PRIVATE(n), hw_words);
+        mpi_hal_write_m_prime(Mprime);
+        mpi_hal_set_mode((hw_words / 16) - 1);
+    }
+    mpi_hal_write_to_mem_block(MPI_PARAM_X, 0, X->MBEDTLS_PRIVATE(p), X->MBEDTLS_PRIVATE(n), hw_words);
+    mpi_hal_write_to_mem_block(MPI_PARAM_Z, 0, Y->MBEDTLS_PRIVATE(p), Y->MBEDTLS_PRIVATE(n), hw_words);
+    mpi_hal_start_op(MPI_MULT);
+    s_counters.mont_hw_op++;
+
+    Z->MBEDTLS_PRIVATE(s) = 1;
+    MBEDTLS_MPI_CHK(mbedtls_mpi_grow(Z, hw_words));
+    mpi_hal_read_result_hw_op(Z->MBEDTLS_PRIVATE(p), Z->MBEDTLS_PRIVATE(n), hw_words);
+    Z->MBEDTLS_PRIVATE(s) = 1;
+
+    // Same guard as the port: the hardware leaves the result below 2M
+    if (mbedtls_mpi_cmp_mpi(Z, M) >= 0) {
+        MBEDTLS_MPI_CHK(mbedtls_mpi_sub_abs(Z, Z, M));
+    }
+
+cleanup:
+    return ret;
+}
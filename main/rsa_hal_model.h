@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+#include "mbedtls/bignum.h"
+
+// Software model of the ESP32 RSA accelerator for the linux target. It
+// provides the parts of the mbedtls port (bignum_impl.h), the mpi HAL and
+// the peripheral registers that rsa_hw.c, rsa_async.c, rsa_big.c and
+// rsa_debug.c use, over four 512-byte memory blocks in RAM:
+// - Montgomery mode (mode 0..7) runs word-serial CIOS with the loaded M'
+//   and gives Z = X * Y * R^-1 mod M, R = 2^(32 * hw_words).
+// - Plain multiply mode (mode 8..15) gives the 2 * hw_words product of X
+//   and the upper half of Z.
+// - Operations complete immediately; the completion interrupt, when
+//   enabled, is delivered to the handler from esp_intr_alloc before
+//   mpi_hal_start_op returns.
+// Misuse the peripheral would not survive (memory or op access while
+// disabled, unbalanced enable/disable, waiting with no op started, an M'
+// that does not match M) aborts with a message.
+
+#define RSA_MODEL_BLOCK_WORDS 128
+
+// Memory blocks and registers, addressed like the chip's through
+// DPORT_REG_READ and plain volatile pointers
+extern volatile uint32_t rsa_model_mem[4][RSA_MODEL_BLOCK_WORDS];
+
+typedef struct {
+    volatile uint32_t m_dash;
+    volatile uint32_t mult_mode;
+    volatile uint32_t mult_start;
+    volatile uint32_t interrupt;
+    volatile uint32_t query_clean;
+} rsa_model_regs_t;
+
+extern rsa_model_regs_t rsa_model_regs;
+
+typedef enum { MPI_MULT = 0x0, MPI_MODMULT, MPI_MODEXP } mpi_op_t;
+typedef enum { MPI_PARAM_X, MPI_PARAM_Y, MPI_PARAM_Z, MPI_PARAM_M } mpi_param_t;
+
+#define RSA_MEM_X_BLOCK_BASE ((uintptr_t)rsa_model_mem[MPI_PARAM_X])
+#define RSA_MEM_Y_BLOCK_BASE ((uintptr_t)rsa_model_mem[MPI_PARAM_Y])
+#define RSA_MEM_Z_BLOCK_BASE ((uintptr_t)rsa_model_mem[MPI_PARAM_Z])
+#define RSA_MEM_M_BLOCK_BASE ((uintptr_t)rsa_model_mem[MPI_PARAM_M])
+#define RSA_M_DASH_REG ((uintptr_t)&rsa_model_regs.m_dash)
+#define RSA_MULT_MODE_REG ((uintptr_t)&rsa_model_regs.mult_mode)
+#define RSA_MULT_START_REG ((uintptr_t)&rsa_model_regs.mult_start)
+#define RSA_INTERRUPT_REG ((uintptr_t)&rsa_model_regs.interrupt)
+#define RSA_QUERY_INTERRUPT_REG ((uintptr_t)&rsa_model_regs.interrupt)
+#define RSA_QUERY_CLEAN_REG ((uintptr_t)&rsa_model_regs.query_clean)
+
+#define DPORT_REG_READ(r) (*(volatile uint32_t *)(r))
+#define DPORT_REG_WRITE(r, v) (*(volatile uint32_t *)(r) = (v))
+
+// Interrupt allocation, for the RSA source only
+#define ETS_RSA_INTR_SOURCE 47
+typedef void *intr_handle_t;
+typedef void (*intr_handler_t)(void *arg);
+esp_err_t esp_intr_alloc(int source, int flags, intr_handler_t handler, void *arg, intr_handle_t *ret_handle);
+
+// mbedtls port (bignum_impl.h)
+size_t esp_mpi_hardware_words(size_t words);
+void esp_mpi_enable_hardware_hw_op(void);
+void esp_mpi_disable_hardware_hw_op(void);
+void esp_mpi_mul_mpi_mod_hw_op(const mbedtls_mpi *X, const mbedtls_mpi *Y, const mbedtls_mpi *M,
+                               const mbedtls_mpi *Rinv, mbedtls_mpi_uint Mprime, size_t hw_words);
+void esp_mpi_mul_mpi_hw_op(const mbedtls_mpi *X, const mbedtls_mpi *Y, size_t num_words);
+int esp_mont_hw_op(mbedtls_mpi *Z, const mbedtls_mpi *X, const mbedtls_mpi *Y, const mbedtls_mpi *M,
+                   mbedtls_mpi_uint Mprime, size_t hw_words, bool again);
+
+// mpi HAL (hal/mpi_hal.h)
+size_t mpi_hal_calc_hardware_words(size_t words);
+void mpi_hal_enable_hardware_hw_op(void);
+void mpi_hal_disable_hardware_hw_op(void);
+void mpi_hal_interrupt_enable(bool enable);
+void mpi_hal_clear_interrupt(void);
+void mpi_hal_set_mode(const size_t num_words);
+void mpi_hal_write_to_mem_block(mpi_param_t param, size_t offset, const uint32_t *p, size_t n, size_t num_words);
+void mpi_hal_write_at_offset(mpi_param_t param, int offset, uint32_t value);
+void mpi_hal_write_m_prime(uint32_t Mprime);
+void mpi_hal_write_rinv(uint32_t rinv);
+void mpi_hal_start_op(mpi_op_t op);
+void mpi_hal_wait_op_complete(void);
+void mpi_hal_read_result_hw_op(uint32_t *p, size_t n, size_t z_words);
+
+// Per-call counters, cumulative since the last reset
+typedef struct {
+    size_t montmul;          // MPI_MULT in Montgomery mode
+    size_t plainmul;         // MPI_MULT in plain multiply mode
+    size_t mont_hw_op;       // esp_mont_hw_op calls
+    size_t mul_mod_hw_op;    // esp_mpi_mul_mpi_mod_hw_op calls
+    size_t enables;          // esp_mpi_enable_hardware_hw_op calls
+    size_t words_written;    // words stored into the memory blocks
+    size_t words_read;       // result words read back
+    size_t interrupts;       // completion interrupts delivered
+} rsa_model_counters_t;
+
+void rsa_model_get_counters(rsa_model_counters_t *out);
+void rsa_model_reset_counters(void);
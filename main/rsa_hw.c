@@ -2,15 +2,146 @@
 #include <stdio.h>
 #include <inttypes.h>
 #include <string.h>
+#include <stdatomic.h>
 #include "esp_random.h"
+#include "esp_heap_caps.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "soc/dport_reg.h"
-#include "bignum_impl.h"
-#include "hal/mpi_hal.h"
+#include "rsa_hal.h"
+#include "mbedtls/platform.h"
 
 // ==================== WORKING FUNCTIONS ====================
 
+// Heap calls made by this module and, once the hook is installed, by
+// mbedtls. Each allocation and each non-NULL free counts as one call.
+// Atomic because the mbedtls hook runs for every task, not just the one
+// being measured.
+static atomic_size_t s_heap_calls;
+
+static void heap_call(void) {
+    atomic_fetch_add_explicit(&s_heap_calls, 1, memory_order_relaxed);
+}
+
+static void *hw_calloc_caps(size_t n, size_t size, uint32_t caps) {
+    heap_call();
+    return heap_caps_calloc(n, size, caps);
+}
+
+static void *hw_calloc(size_t n, size_t size) {
+    return hw_calloc_caps(n, size, MALLOC_CAP_DEFAULT);
+}
+
+static void *hw_malloc(size_t size) {
+    heap_call();
+    return heap_caps_malloc(size, MALLOC_CAP_DEFAULT);
+}
+
+static void hw_free(void *p) {
+    if (p) {
+        heap_call();
+        heap_caps_free(p);
+    }
+}
+
+void rsa_heap_counter_install(void) {
+#if defined(MBEDTLS_PLATFORM_MEMORY) && !defined(MBEDTLS_PLATFORM_CALLOC_MACRO)
+    mbedtls_platform_set_calloc_free(hw_calloc, hw_free);
+#endif
+}
+
+size_t rsa_heap_calls(void) {
+    return atomic_load_explicit(&s_heap_calls, memory_order_relaxed);
+}
+
+// ==================== OPERATION COUNTERS ====================
+
+#if RSA_HW_OP_COUNTERS
+static rsa_hw_op_counts_t s_ops;
+#define OPS_ADD(field, v) (s_ops.field += (size_t)(v))
+#else
+#define OPS_ADD(field, v) ((void)0)
+#endif
+
+void rsa_hw_op_counts_get(rsa_hw_op_counts_t *out) {
+#if RSA_HW_OP_COUNTERS
+    *out = s_ops;
+#else
+    memset(out, 0, sizeof(*out));
+#endif
+}
+
+void rsa_hw_op_counts_reset(void) {
+#if RSA_HW_OP_COUNTERS
+    memset(&s_ops, 0, sizeof(s_ops));
+#endif
+}
+
+void rsa_hw_op_counts_sub(rsa_hw_op_counts_t *acc, const rsa_hw_op_counts_t *after,
+                          const rsa_hw_op_counts_t *before) {
+    acc->montmuls += after->montmuls - before->montmuls;
+    acc->squarings += after->squarings - before->squarings;
+    acc->enables += after->enables - before->enables;
+    acc->disables += after->disables - before->disables;
+    acc->operand_loads += after->operand_loads - before->operand_loads;
+    acc->modulus_loads += after->modulus_loads - before->modulus_loads;
+    acc->result_reads += after->result_reads - before->result_reads;
+    acc->bytes_copied += after->bytes_copied - before->bytes_copied;
+}
+
+// Every accelerator access in this file goes through these
+static inline void hw_enable(void) {
+    OPS_ADD(enables, 1);
+    esp_mpi_enable_hardware_hw_op();
+}
+
+static inline void hw_disable(void) {
+    OPS_ADD(disables, 1);
+    esp_mpi_disable_hardware_hw_op();
+}
+
+static inline void hw_write_block(mpi_param_t param, size_t offset, const uint32_t *p, size_t n, size_t num_words) {
+    if (param == MPI_PARAM_M) {
+        OPS_ADD(modulus_loads, 1);
+    } else {
+        OPS_ADD(operand_loads, 1);
+    }
+    OPS_ADD(bytes_copied, num_words * 4);
+    mpi_hal_write_to_mem_block(param, offset, p, n, num_words);
+}
+
+static inline void hw_start_mult(void) {
+    OPS_ADD(montmuls, 1);
+    mpi_hal_start_op(MPI_MULT);
+}
+
+static inline void hw_read_block(uint32_t *p, size_t n, size_t z_words) {
+    OPS_ADD(result_reads, 1);
+    OPS_ADD(bytes_copied, z_words * 4);
+    mpi_hal_read_result_hw_op(p, n, z_words);
+}
+
+// Loads X and Y (and M unless again), runs one montmul and reads Z back
+static inline int hw_mont(mbedtls_mpi *Z, const mbedtls_mpi *X, const mbedtls_mpi *Y, const mbedtls_mpi *M,
+                          mbedtls_mpi_uint mprime, size_t hw_words, bool again) {
+    OPS_ADD(montmuls, 1);
+    OPS_ADD(squarings, X == Y);
+    OPS_ADD(operand_loads, 2);
+    OPS_ADD(modulus_loads, !again);
+    OPS_ADD(result_reads, 1);
+    OPS_ADD(bytes_copied, (again ? 3 : 4) * hw_words * 4);
+    return esp_mont_hw_op(Z, X, Y, M, mprime, hw_words, again);
+}
+
+// Loads M, X and R^2, then Y: two montmuls, result left for the caller
+static inline void hw_mul_mod(const mbedtls_mpi *X, const mbedtls_mpi *Y, const mbedtls_mpi *M,
+                              const mbedtls_mpi *Rinv, mbedtls_mpi_uint mprime, size_t hw_words) {
+    OPS_ADD(montmuls, 2);
+    OPS_ADD(operand_loads, 3);
+    OPS_ADD(modulus_loads, 1);
+    OPS_ADD(bytes_copied, 4 * hw_words * 4);
+    esp_mpi_mul_mpi_mod_hw_op(X, Y, M, Rinv, mprime, hw_words);
+}
+
 static uint32_t montmul_init_u32(const uint32_t *n) {
     uint32_t x = n[0];
     x += ((n[0] + 2) & 4) << 1;
@@ -54,8 +185,65 @@ void rsa_mpi_get_words(const mbedtls_mpi *X, uint32_t *words, size_t n_words) {
     memcpy(words, X->MBEDTLS_PRIVATE(p), copy_words * sizeof(uint32_t));
 }
 
+// Rinv = R^2 mod M, mostly on the accelerator. Software doubling takes
+// 2^(msb(M)) up to 2^(32*hw_words + j) mod M, which is 2^j in Montgomery
+// form; each Montgomery squaring then doubles the exponent, and j is picked
+// so that `squarings` of them land exactly on R * 2^(32*hw_words) = R^2.
+static bool mont_rr_hw(rsa_mont_ctx_t *ctx) {
+    const size_t hw_words = ctx->hw_words;
+    size_t j = 32 * hw_words;
+    size_t squarings = 0;
+    while ((j & 1) == 0 && j / 2 >= 32) {
+        j /= 2;
+        squarings++;
+    }
+
+    if (mbedtls_mpi_grow(&ctx->Rinv, hw_words) != 0) {
+        return false;
+    }
+    uint32_t *t = ctx->Rinv.MBEDTLS_PRIVATE(p);
+    const uint32_t *m = ctx->M.MBEDTLS_PRIVATE(p);
+    const size_t m_words = ctx->M.MBEDTLS_PRIVATE(n);
+    memset(t, 0, ctx->Rinv.MBEDTLS_PRIVATE(n) * sizeof(uint32_t));
+    ctx->Rinv.MBEDTLS_PRIVATE(s) = 1;
+
+    size_t msb = mpi_msb(&ctx->M);
+    t[msb / 32] = 1u << (msb % 32);
+    for (size_t b = msb; b < 32 * hw_words + j; b++) {
+        // t < M, so 2t needs at most one subtraction
+        uint32_t carry = 0;
+        for (size_t i = 0; i < hw_words; i++) {
+            uint32_t w = t[i];
+            t[i] = (w << 1) | carry;
+            carry = w >> 31;
+        }
+        int cmp = carry ? 1 : 0;
+        for (size_t i = hw_words; i-- > 0 && cmp == 0;) {
+            uint32_t mi = (i < m_words) ? m[i] : 0;
+            cmp = (t[i] > mi) - (t[i] < mi);
+        }
+        if (cmp >= 0) {
+            uint32_t borrow = 0;
+            for (size_t i = 0; i < hw_words; i++) {
+                uint64_t d = (uint64_t)t[i] - ((i < m_words) ? m[i] : 0) - borrow;
+                t[i] = (uint32_t)d;
+                borrow = (uint32_t)(d >> 63);
+            }
+        }
+    }
+
+    bool ok = true;
+    hw_enable();
+    for (size_t k = 0; k < squarings && ok; k++) {
+        ok = hw_mont(&ctx->Rinv, &ctx->Rinv, &ctx->Rinv, &ctx->M, ctx->mprime, hw_words, k > 0) == 0;
+    }
+    hw_disable();
+    return ok;
+}
+
 bool rsa_mont_ctx_init(rsa_mont_ctx_t *ctx, const uint32_t *M_words, size_t words) {
-    if (!ctx || !M_words || words == 0) {
+    // Wider moduli go through rsa_big_ctx_t
+    if (!ctx || !M_words || words == 0 || words > RSA_4096_WORDS) {
         return false;
     }
     if ((M_words[0] & 1u) == 0) {
@@ -66,26 +254,63 @@ bool rsa_mont_ctx_init(rsa_mont_ctx_t *ctx, const uint32_t *M_words, size_t word
     ctx->hw_words = esp_mpi_hardware_words(words);
     mbedtls_mpi_init(&ctx->M);
     mbedtls_mpi_init(&ctx->Rinv);
+    mbedtls_mpi_init(&ctx->one);
+    ctx->scratch = NULL;
+    ctx->scratch_regs = 0;
+    ctx->steps = NULL;
+    ctx->step_capacity = 0;
 
     if (!rsa_mpi_set_words(&ctx->M, M_words, words)) {
         rsa_mont_ctx_free(ctx);
         return false;
     }
 
-    if (mbedtls_mpi_lset(&ctx->Rinv, 1) != 0) {
+    ctx->mprime = montmul_init_u32(ctx->M.MBEDTLS_PRIVATE(p));
+
+    if (!mont_rr_hw(ctx)) {
         rsa_mont_ctx_free(ctx);
         return false;
     }
-    if (mbedtls_mpi_shift_l(&ctx->Rinv, ctx->hw_words * 2 * 32) != 0) {
+
+    // Padded 1 for the conversion out of Montgomery form
+    if (mbedtls_mpi_grow(&ctx->one, ctx->hw_words) != 0 ||
+        mbedtls_mpi_set_bit(&ctx->one, 0, 1) != 0) {
         rsa_mont_ctx_free(ctx);
         return false;
     }
-    if (mbedtls_mpi_mod_mpi(&ctx->Rinv, &ctx->Rinv, &ctx->M) != 0) {
+
+    // Scratch arena for exponentiation: the odd-power table for the widest
+    // window a modulus-sized exponent uses, plus X^2 and the accumulator.
+    size_t max_bits = ctx->hw_words * 32;
+    size_t window = rsa_exp_window_size(max_bits);
+    size_t regs = (size_t)1 << (window - 1);
+    if (regs < RSA_EXP_CHAIN_REGS) {
+        regs = RSA_EXP_CHAIN_REGS;
+    }
+    ctx->scratch = hw_calloc(regs + 2, sizeof(mbedtls_mpi));
+    if (!ctx->scratch) {
         rsa_mont_ctx_free(ctx);
         return false;
     }
+    ctx->scratch_regs = regs;
+    for (size_t r = 0; r < regs + 2; r++) {
+        mbedtls_mpi_init(&ctx->scratch[r]);
+    }
+    for (size_t r = 0; r < regs + 2; r++) {
+        if (mbedtls_mpi_grow(&ctx->scratch[r], ctx->hw_words) != 0) {
+            rsa_mont_ctx_free(ctx);
+            return false;
+        }
+    }
 
-    ctx->mprime = montmul_init_u32(ctx->M.MBEDTLS_PRIVATE(p));
+    // Sliding windows are at least `window` bits apart, which bounds the
+    // recoding of any exponent up to max_bits
+    ctx->step_capacity = (max_bits + window - 1) / window;
+    ctx->steps = hw_calloc(ctx->step_capacity, sizeof(rsa_exp_step_t));
+    if (!ctx->steps) {
+        rsa_mont_ctx_free(ctx);
+        return false;
+    }
     return true;
 }
 
@@ -95,107 +320,1362 @@ void rsa_mont_ctx_free(rsa_mont_ctx_t *ctx) {
     }
     mbedtls_mpi_free(&ctx->M);
     mbedtls_mpi_free(&ctx->Rinv);
+    mbedtls_mpi_free(&ctx->one);
+    if (ctx->scratch) {
+        for (size_t r = 0; r < ctx->scratch_regs + 2; r++) {
+            mbedtls_mpi_free(&ctx->scratch[r]);
+        }
+        hw_free(ctx->scratch);
+    }
+    hw_free(ctx->steps);
+    ctx->scratch = NULL;
+    ctx->scratch_regs = 0;
+    ctx->steps = NULL;
+    ctx->step_capacity = 0;
     ctx->words = 0;
     ctx->hw_words = 0;
     ctx->mprime = 0;
 }
 
+bool rsa_mod_mult_hw_batch(const rsa_mont_ctx_t *ctx,
+                           const mbedtls_mpi *const *X, const mbedtls_mpi *const *Y,
+                           mbedtls_mpi *const *Z, size_t count) {
+    if (!ctx || !X || !Y || !Z) {
+        return false;
+    }
+
+    bool ok = true;
+    hw_enable();
+    for (size_t i = 0; i < count; i++) {
+        hw_mul_mod(X[i], Y[i], &ctx->M, &ctx->Rinv, ctx->mprime, ctx->hw_words);
+        if (mbedtls_mpi_grow(Z[i], ctx->hw_words) != 0) {
+            ok = false;
+            break;
+        }
+        hw_read_block(Z[i]->MBEDTLS_PRIVATE(p), Z[i]->MBEDTLS_PRIVATE(n), ctx->hw_words);
+        Z[i]->MBEDTLS_PRIVATE(s) = 1;
+        // The hardware leaves Z below 2M; finish the reduction so the
+        // result matches mbedtls bit for bit
+        if (mbedtls_mpi_cmp_mpi(Z[i], &ctx->M) >= 0 && mbedtls_mpi_sub_abs(Z[i], Z[i], &ctx->M) != 0) {
+            ok = false;
+            break;
+        }
+    }
+    hw_disable();
+    return ok;
+}
+
 bool rsa_mod_mult_hw_ctx(const rsa_mont_ctx_t *ctx,
                          const mbedtls_mpi *X, const mbedtls_mpi *Y,
                          mbedtls_mpi *Z) {
-    if (!ctx || !X || !Y || !Z) {
+    return rsa_mod_mult_hw_batch(ctx, &X, &Y, &Z, 1);
+}
+
+void rsa_mont_elem_init(rsa_mont_elem_t *A) {
+    mbedtls_mpi_init(&A->v);
+}
+
+void rsa_mont_elem_free(rsa_mont_elem_t *A) {
+    if (!A) {
+        return;
+    }
+    mbedtls_mpi_free(&A->v);
+}
+
+bool rsa_mont_to_mont(const rsa_mont_ctx_t *ctx, const mbedtls_mpi *X, rsa_mont_elem_t *A) {
+    if (!ctx || !X || !A) {
         return false;
     }
 
-    esp_mpi_enable_hardware_hw_op();
-    esp_mpi_mul_mpi_mod_hw_op(X, Y, &ctx->M, &ctx->Rinv, ctx->mprime, ctx->hw_words);
+    // mont(X, R^2 mod M) = X * R mod M
+    hw_enable();
+    int ret = hw_mont(&A->v, X, &ctx->Rinv, &ctx->M, ctx->mprime, ctx->hw_words, false);
+    hw_disable();
+    return ret == 0;
+}
+
+bool rsa_mont_from_mont(const rsa_mont_ctx_t *ctx, const rsa_mont_elem_t *A, mbedtls_mpi *X) {
+    if (!ctx || !A || !X) {
+        return false;
+    }
+
+    // mont(A, 1) = A * R^-1 mod M, using a single-limb 1 to avoid allocating
+    mbedtls_mpi_uint one_limb = 1;
+    mbedtls_mpi one;
+    one.MBEDTLS_PRIVATE(s) = 1;
+    one.MBEDTLS_PRIVATE(n) = 1;
+    one.MBEDTLS_PRIVATE(p) = &one_limb;
+
+    hw_enable();
+    int ret = hw_mont(X, &A->v, &one, &ctx->M, ctx->mprime, ctx->hw_words, false);
+    hw_disable();
+    return ret == 0;
+}
+
+bool rsa_mont_mul(const rsa_mont_ctx_t *ctx, const rsa_mont_elem_t *A,
+                  const rsa_mont_elem_t *B, rsa_mont_elem_t *Z) {
+    if (!ctx || !A || !B || !Z) {
+        return false;
+    }
+
+    hw_enable();
+    int ret = hw_mont(&Z->v, &A->v, &B->v, &ctx->M, ctx->mprime, ctx->hw_words, false);
+    hw_disable();
+    return ret == 0;
+}
+
+bool rsa_mont_sqr(const rsa_mont_ctx_t *ctx, const rsa_mont_elem_t *A, rsa_mont_elem_t *Z) {
+    return rsa_mont_mul(ctx, A, A, Z);
+}
+
+size_t rsa_exp_window_size(size_t exp_bits) {
+    // Same thresholds as mbedtls: balances the odd-power table cost against
+    // the multiplies saved per window.
+    if (exp_bits > 671) return 6;
+    if (exp_bits > 239) return 5;
+    if (exp_bits > 79) return 4;
+    if (exp_bits > 23) return 3;
+    return 1;
+}
+
+// Recodes E into `steps` when given (failing if it does not fit), or into a
+// freshly allocated array otherwise.
+static bool exp_plan_recode(rsa_exp_plan_t *plan, const mbedtls_mpi *E, size_t window,
+                            rsa_exp_step_t *steps, size_t capacity) {
+    if (!plan || !E) {
+        return false;
+    }
+    memset(plan, 0, sizeof(*plan));
+    if (mbedtls_mpi_cmp_int(E, 0) == 0) {
+        return true;
+    }
+
+    int t = (int)mpi_msb(E);
+    if (window == 0) {
+        window = rsa_exp_window_size((size_t)t + 1);
+    }
+    if (window > 8) {
+        return false;
+    }
+
+    // Consecutive windows start at least `window` bits apart
+    size_t max_steps = ((size_t)t + window) / window;
+    if (steps) {
+        if (max_steps > capacity) {
+            return false;
+        }
+        plan->steps = steps;
+    } else {
+        plan->steps = hw_calloc(max_steps, sizeof(rsa_exp_step_t));
+        if (!plan->steps) {
+            return false;
+        }
+    }
+    plan->window = window;
+
+    size_t pending = 0;
+    uint32_t max_digit = 1;
+    for (int i = t; i >= 0;) {
+        if (!mbedtls_mpi_get_bit(E, i)) {
+            pending++;
+            i--;
+            continue;
+        }
+
+        // Longest window of at most `window` bits that ends in a set bit
+        int len = ((int)window < i + 1) ? (int)window : i + 1;
+        while (!mbedtls_mpi_get_bit(E, i - len + 1)) {
+            len--;
+        }
+        uint32_t digit = 0;
+        for (int j = i; j > i - len; j--) {
+            digit = (digit << 1) | (uint32_t)mbedtls_mpi_get_bit(E, j);
+        }
+
+        rsa_exp_step_t *step = &plan->steps[plan->step_count++];
+        step->squarings = (plan->step_count == 1) ? 0 : (uint16_t)(pending + len);
+        step->digit = (uint16_t)digit;
+        if (digit > max_digit) {
+            max_digit = digit;
+        }
+        pending = 0;
+        i -= len;
+    }
+
+    plan->tail_squarings = pending;
+    plan->table_size = (max_digit + 1) / 2;
+    return true;
+}
+
+bool rsa_exp_plan_init(rsa_exp_plan_t *plan, const mbedtls_mpi *E, size_t window) {
+    return exp_plan_recode(plan, E, window, NULL, 0);
+}
+
+static size_t chain_binary_len(uint32_t d) {
+    return (size_t)(31 - __builtin_clz(d)) + (size_t)__builtin_popcount(d) - 1;
+}
+
+static size_t chain_divisor_index(const uint32_t *divs, size_t count, uint32_t d) {
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (divs[mid] < d) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void chain_emit_op(rsa_exp_plan_t *plan, uint8_t dst, uint8_t a, uint8_t b) {
+    rsa_exp_op_t *op = &plan->ops[plan->op_count++];
+    op->dst = dst;
+    op->a = a;
+    op->b = b;
+}
+
+// reg[dst] = reg[src]^divs[idx]. `spare` may be clobbered, and reg[src] is
+// not needed once the first factor has been applied.
+static void chain_emit(rsa_exp_plan_t *plan, const uint32_t *divs, const uint32_t *split,
+                       size_t count, size_t idx, uint8_t src, uint8_t dst, uint8_t spare) {
+    uint32_t d = divs[idx];
+    if (split[idx] != 0) {
+        uint32_t a = split[idx];
+        size_t ia = chain_divisor_index(divs, count, a);
+        size_t ib = chain_divisor_index(divs, count, d / a);
+        chain_emit(plan, divs, split, count, ia, src, spare, dst);
+        chain_emit(plan, divs, split, count, ib, spare, dst, src);
+        return;
+    }
+
+    int msb = 31 - __builtin_clz(d);
+    for (int i = msb - 1; i >= 0; i--) {
+        if (i == msb - 1) {
+            chain_emit_op(plan, dst, src, src);
+        } else {
+            chain_emit_op(plan, dst, dst, dst);
+        }
+        if (d & (1u << i)) {
+            chain_emit_op(plan, dst, dst, src);
+        }
+    }
+}
+
+bool rsa_exp_plan_init_chain(rsa_exp_plan_t *plan, uint32_t e) {
+    if (!plan) {
+        return false;
+    }
+    memset(plan, 0, sizeof(*plan));
+    if (e == 0) {
+        return true;
+    }
+    plan->is_chain = true;
+    if (e == 1) {
+        return true;
+    }
+
+    // Factor e by trial division and count its divisors
+    uint32_t primes[32];
+    uint8_t powers[32];
+    size_t prime_count = 0;
+    size_t div_count = 1;
+    uint32_t n = e;
+    for (uint32_t p = 2; p <= n / p; p += (p == 2) ? 1 : 2) {
+        if (n % p == 0) {
+            primes[prime_count] = p;
+            powers[prime_count] = 0;
+            while (n % p == 0) {
+                n /= p;
+                powers[prime_count]++;
+            }
+            div_count *= (size_t)powers[prime_count] + 1;
+            prime_count++;
+        }
+    }
+    if (n > 1) {
+        primes[prime_count] = n;
+        powers[prime_count] = 1;
+        div_count *= 2;
+        prime_count++;
+    }
+
+    uint32_t *divs = hw_malloc(div_count * sizeof(uint32_t));
+    uint32_t *cost = hw_malloc(div_count * sizeof(uint32_t));
+    uint32_t *split = hw_malloc(div_count * sizeof(uint32_t));
+    if (!divs || !cost || !split) {
+        hw_free(divs);
+        hw_free(cost);
+        hw_free(split);
+        return false;
+    }
+
+    size_t filled = 1;
+    divs[0] = 1;
+    for (size_t i = 0; i < prime_count; i++) {
+        size_t base = filled;
+        uint32_t pk = 1;
+        for (uint8_t k = 0; k < powers[i]; k++) {
+            pk *= primes[i];
+            for (size_t j = 0; j < base; j++) {
+                divs[filled++] = divs[j] * pk;
+            }
+        }
+    }
+    for (size_t i = 1; i < div_count; i++) {
+        uint32_t v = divs[i];
+        size_t j = i;
+        while (j > 0 && divs[j - 1] > v) {
+            divs[j] = divs[j - 1];
+            j--;
+        }
+        divs[j] = v;
+    }
+
+    // Cheapest chain per divisor: binary, or the best split d = a * (d / a)
+    // with the chain for d / a run on top of x^a
+    for (size_t i = 0; i < div_count; i++) {
+        uint32_t d = divs[i];
+        cost[i] = (d == 1) ? 0 : (uint32_t)chain_binary_len(d);
+        split[i] = 0;
+        for (size_t j = 1; j < i; j++) {
+            if (d % divs[j] != 0) {
+                continue;
+            }
+            size_t k = chain_divisor_index(divs, div_count, d / divs[j]);
+            if (cost[j] + cost[k] < cost[i]) {
+                cost[i] = cost[j] + cost[k];
+                split[i] = divs[j];
+            }
+        }
+    }
+
+    bool ok = false;
+    plan->ops = hw_calloc(cost[div_count - 1], sizeof(rsa_exp_op_t));
+    if (plan->ops) {
+        plan->result_reg = 1;
+        chain_emit(plan, divs, split, div_count, div_count - 1, 0, 1, 2);
+        ok = true;
+    }
+
+    hw_free(divs);
+    hw_free(cost);
+    hw_free(split);
+    return ok;
+}
+
+void rsa_exp_plan_free(rsa_exp_plan_t *plan) {
+    if (!plan) {
+        return;
+    }
+    hw_free(plan->steps);
+    hw_free(plan->ops);
+    memset(plan, 0, sizeof(*plan));
+}
+
+size_t rsa_exp_plan_montmuls(const rsa_exp_plan_t *plan) {
+    if (!plan) {
+        return 0;
+    }
+    if (plan->is_chain) {
+        return 2 + plan->op_count;
+    }
+    if (plan->step_count == 0) {
+        return 0;
+    }
+    // Conversion in and out, plus X^2 and the rest of the odd-power table
+    size_t ops = 2 + ((plan->table_size > 1) ? plan->table_size : 0);
+    for (size_t i = 0; i < plan->step_count; i++) {
+        ops += plan->steps[i].squarings + ((i > 0) ? 1 : 0);
+    }
+    return ops + plan->tail_squarings;
+}
+
+// Working set for the exponentiation engine: the odd-power table (or chain
+// registers), X^2 and the accumulator. Borrowed from the context arena, and
+// only allocated for plans wider than the arena.
+typedef struct {
+    mbedtls_mpi *regs;
+    mbedtls_mpi *X2;
+    mbedtls_mpi *acc;
+    const mbedtls_mpi *one;
+    mbedtls_mpi *owned;
+    size_t owned_count;
+} exp_scratch_t;
+
+static void exp_scratch_free(exp_scratch_t *s) {
+    if (s->owned) {
+        for (size_t r = 0; r < s->owned_count; r++) {
+            mbedtls_mpi_free(&s->owned[r]);
+        }
+        hw_free(s->owned);
+    }
+    s->owned = NULL;
+    s->owned_count = 0;
+}
+
+static bool exp_scratch_init(exp_scratch_t *s, const rsa_mont_ctx_t *ctx, const rsa_exp_plan_t *plan) {
+    size_t count = plan->is_chain ? RSA_EXP_CHAIN_REGS : plan->table_size;
+    s->one = &ctx->one;
+    s->owned = NULL;
+    s->owned_count = 0;
+
+    mbedtls_mpi *regs = ctx->scratch;
+    size_t reg_count = ctx->scratch_regs;
+    if (count > reg_count) {
+        s->owned = hw_calloc(count + 2, sizeof(mbedtls_mpi));
+        if (!s->owned) {
+            return false;
+        }
+        for (size_t r = 0; r < count + 2; r++) {
+            mbedtls_mpi_init(&s->owned[r]);
+        }
+        s->owned_count = count + 2;
+        for (size_t r = 0; r < count + 2; r++) {
+            if (mbedtls_mpi_grow(&s->owned[r], ctx->hw_words) != 0) {
+                exp_scratch_free(s);
+                return false;
+            }
+        }
+        regs = s->owned;
+        reg_count = count;
+    }
+
+    s->regs = regs;
+    s->X2 = &regs[reg_count];
+    s->acc = &regs[reg_count + 1];
+    return true;
+}
+
+static bool exp_plan_is_empty(const rsa_exp_plan_t *plan) {
+    return !plan->is_chain && plan->step_count == 0;
+}
+
+// Runs the plan with the peripheral enabled and regs[0] = X * R mod M.
+// Returns the result, still in Montgomery form, or NULL on failure.
+static const mbedtls_mpi *exp_body_locked(const rsa_mont_ctx_t *ctx, const rsa_exp_plan_t *plan,
+                                          exp_scratch_t *s) {
+    mbedtls_mpi *regs = s->regs;
+    mbedtls_mpi *Z = s->acc;
+
+    if (plan->is_chain) {
+        for (size_t i = 0; i < plan->op_count; i++) {
+            const rsa_exp_op_t *op = &plan->ops[i];
+            if (hw_mont(&regs[op->dst], &regs[op->a], &regs[op->b],
+                               &ctx->M, ctx->mprime, ctx->hw_words, true) != 0) {
+                return NULL;
+            }
+        }
+        return (plan->op_count > 0) ? &regs[plan->result_reg] : &regs[0];
+    }
+
+    // regs[k] = X^(2k+1) in Montgomery form
+    if (plan->table_size > 1) {
+        if (hw_mont(s->X2, &regs[0], &regs[0], &ctx->M, ctx->mprime, ctx->hw_words, true) != 0) {
+            return NULL;
+        }
+        for (size_t k = 1; k < plan->table_size; k++) {
+            if (hw_mont(&regs[k], &regs[k - 1], s->X2, &ctx->M, ctx->mprime, ctx->hw_words, true) != 0) {
+                return NULL;
+            }
+        }
+    }
+
+    if (mbedtls_mpi_copy(Z, &regs[plan->steps[0].digit >> 1]) != 0) {
+        return NULL;
+    }
+    for (size_t i = 1; i < plan->step_count; i++) {
+        const rsa_exp_step_t *step = &plan->steps[i];
+        for (uint16_t k = 0; k < step->squarings; k++) {
+            if (hw_mont(Z, Z, Z, &ctx->M, ctx->mprime, ctx->hw_words, true) != 0) {
+                return NULL;
+            }
+        }
+        if (hw_mont(Z, Z, &regs[step->digit >> 1], &ctx->M, ctx->mprime, ctx->hw_words, true) != 0) {
+            return NULL;
+        }
+    }
+    for (size_t k = 0; k < plan->tail_squarings; k++) {
+        if (hw_mont(Z, Z, Z, &ctx->M, ctx->mprime, ctx->hw_words, true) != 0) {
+            return NULL;
+        }
+    }
+    return Z;
+}
+
+// One exponentiation with the peripheral already enabled. `again` skips
+// reloading M when a previous op in the same session already did.
+static bool exp_plan_locked(const rsa_mont_ctx_t *ctx, const mbedtls_mpi *X,
+                            const rsa_exp_plan_t *plan, exp_scratch_t *s,
+                            mbedtls_mpi *Z, bool again) {
+    if (exp_plan_is_empty(plan)) {
+        return mbedtls_mpi_lset(Z, 1) == 0;
+    }
     if (mbedtls_mpi_grow(Z, ctx->hw_words) != 0) {
-        esp_mpi_disable_hardware_hw_op();
         return false;
     }
-    mpi_hal_read_result_hw_op(Z->MBEDTLS_PRIVATE(p), Z->MBEDTLS_PRIVATE(n), ctx->hw_words);
-    esp_mpi_disable_hardware_hw_op();
+
+    // regs[0] = mont(X, R^2 mod M) = X * R mod M
+    if (hw_mont(&s->regs[0], X, &ctx->Rinv, &ctx->M, ctx->mprime, ctx->hw_words, again) != 0) {
+        return false;
+    }
+    const mbedtls_mpi *result = exp_body_locked(ctx, plan, s);
+    if (!result) {
+        return false;
+    }
+
+    // Convert back from Montgomery domain
+    return hw_mont(Z, result, s->one, &ctx->M, ctx->mprime, ctx->hw_words, true) == 0;
+}
+
+bool rsa_mod_exp_hw_batch(const rsa_mont_ctx_t *ctx,
+                          const mbedtls_mpi *const *X, const rsa_exp_plan_t *plan,
+                          mbedtls_mpi *const *Z, size_t count, bool feed_wdt) {
+    if (!ctx || !X || !plan || !Z) {
+        return false;
+    }
+    (void)feed_wdt;
+
+    exp_scratch_t scratch;
+    if (!exp_scratch_init(&scratch, ctx, plan)) {
+        return false;
+    }
+
+    bool ok = true;
+    hw_enable();
+    for (size_t i = 0; i < count && ok; i++) {
+        ok = exp_plan_locked(ctx, X[i], plan, &scratch, Z[i], i > 0);
+    }
+    hw_disable();
+
+    exp_scratch_free(&scratch);
+    return ok;
+}
+
+bool rsa_mod_exp_hw_plan(const rsa_mont_ctx_t *ctx,
+                         const mbedtls_mpi *X, const rsa_exp_plan_t *plan,
+                         mbedtls_mpi *Z, bool feed_wdt) {
+    return rsa_mod_exp_hw_batch(ctx, &X, plan, &Z, 1, feed_wdt);
+}
+
+// ==================== ZERO-COPY OPERAND PATH ====================
+
+static void hw_load_modulus(const rsa_mont_ctx_t *ctx) {
+    hw_write_block(MPI_PARAM_M, 0, ctx->M.MBEDTLS_PRIVATE(p), ctx->M.MBEDTLS_PRIVATE(n), ctx->hw_words);
+    mpi_hal_write_m_prime(ctx->mprime);
+    mpi_hal_set_mode((ctx->hw_words / 16) - 1);
+}
+
+// Operands are ctx->words little-endian words, or ctx->words * 4 big-endian
+// bytes, written straight into a memory block and zero-padded to hw_words.
+static void hw_write_operand(const rsa_mont_ctx_t *ctx, mpi_param_t param, const void *src, bool be_bytes) {
+    if (!be_bytes) {
+        hw_write_block(param, 0, (const uint32_t *)src, ctx->words, ctx->hw_words);
+        return;
+    }
+    OPS_ADD(operand_loads, 1);
+    OPS_ADD(bytes_copied, ctx->hw_words * 4);
+    const uint8_t *bytes = (const uint8_t *)src;
+    for (size_t i = 0; i < ctx->words; i++) {
+        const uint8_t *b = bytes + (ctx->words - 1 - i) * 4;
+        uint32_t w = ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | (uint32_t)b[3];
+        mpi_hal_write_at_offset(param, (int)(i * 4), w);
+    }
+    for (size_t i = ctx->words; i < ctx->hw_words; i++) {
+        mpi_hal_write_at_offset(param, (int)(i * 4), 0);
+    }
+}
+
+// Waits for the pending op and copies the result into the caller's buffer.
+// The hardware leaves it below 2M, which can need every word of the block,
+// so it is read at hw_words width into scratch register 0 (free once the
+// last op is loaded), brought below M and then copied out.
+static bool hw_read_result(const rsa_mont_ctx_t *ctx, void *dst, bool be_bytes) {
+    mbedtls_mpi *r = &ctx->scratch[0];
+    hw_read_block(r->MBEDTLS_PRIVATE(p), r->MBEDTLS_PRIVATE(n), ctx->hw_words);
+    r->MBEDTLS_PRIVATE(s) = 1;
+    if (mbedtls_mpi_cmp_mpi(r, &ctx->M) >= 0 && mbedtls_mpi_sub_abs(r, r, &ctx->M) != 0) {
+        return false;
+    }
+
+    OPS_ADD(bytes_copied, ctx->words * 4);
+    const uint32_t *w = r->MBEDTLS_PRIVATE(p);
+    if (!be_bytes) {
+        memcpy(dst, w, ctx->words * 4);
+        return true;
+    }
+    uint8_t *bytes = (uint8_t *)dst;
+    for (size_t i = 0; i < ctx->words; i++) {
+        uint8_t *b = bytes + (ctx->words - 1 - i) * 4;
+        b[0] = (uint8_t)(w[i] >> 24);
+        b[1] = (uint8_t)(w[i] >> 16);
+        b[2] = (uint8_t)(w[i] >> 8);
+        b[3] = (uint8_t)w[i];
+    }
     return true;
 }
 
+static bool mod_mult_raw(const rsa_mont_ctx_t *ctx, const void *X, const void *Y, void *Z, bool be_bytes) {
+    if (!ctx || !X || !Y || !Z) {
+        return false;
+    }
+
+    // Same two stages as esp_mpi_mul_mpi_mod_hw_op: X * R, then * Y * R^-1
+    hw_enable();
+    hw_load_modulus(ctx);
+    hw_write_operand(ctx, MPI_PARAM_X, X, be_bytes);
+    hw_write_block(MPI_PARAM_Z, 0, ctx->Rinv.MBEDTLS_PRIVATE(p), ctx->Rinv.MBEDTLS_PRIVATE(n), ctx->hw_words);
+    hw_start_mult();
+    mpi_hal_wait_op_complete();
+    hw_write_operand(ctx, MPI_PARAM_X, Y, be_bytes);
+    hw_start_mult();
+    bool ok = hw_read_result(ctx, Z, be_bytes);
+    hw_disable();
+    return ok;
+}
+
+static bool mod_exp_raw(const rsa_mont_ctx_t *ctx, const void *X, const rsa_exp_plan_t *plan,
+                        void *Z, bool be_bytes) {
+    if (!ctx || !X || !plan || !Z) {
+        return false;
+    }
+    if (exp_plan_is_empty(plan)) {
+        memset(Z, 0, ctx->words * 4);
+        if (be_bytes) {
+            ((uint8_t *)Z)[ctx->words * 4 - 1] = 1;
+        } else {
+            ((uint32_t *)Z)[0] = 1;
+        }
+        return true;
+    }
+
+    exp_scratch_t scratch;
+    if (!exp_scratch_init(&scratch, ctx, plan)) {
+        return false;
+    }
+    mbedtls_mpi *X_mont = &scratch.regs[0];
+
+    bool ok = false;
+    hw_enable();
+
+    // X_mont = mont(X, R^2 mod M), loaded straight from the caller's buffer
+    hw_load_modulus(ctx);
+    hw_write_operand(ctx, MPI_PARAM_X, X, be_bytes);
+    hw_write_block(MPI_PARAM_Z, 0, ctx->Rinv.MBEDTLS_PRIVATE(p), ctx->Rinv.MBEDTLS_PRIVATE(n), ctx->hw_words);
+    hw_start_mult();
+    hw_read_block(X_mont->MBEDTLS_PRIVATE(p), X_mont->MBEDTLS_PRIVATE(n), ctx->hw_words);
+    if (mbedtls_mpi_cmp_mpi(X_mont, &ctx->M) >= 0 && mbedtls_mpi_sub_abs(X_mont, X_mont, &ctx->M) != 0) {
+        goto disable;
+    }
+
+    const mbedtls_mpi *result = exp_body_locked(ctx, plan, &scratch);
+    if (!result) {
+        goto disable;
+    }
+
+    hw_write_block(MPI_PARAM_X, 0, result->MBEDTLS_PRIVATE(p), result->MBEDTLS_PRIVATE(n), ctx->hw_words);
+    hw_write_block(MPI_PARAM_Z, 0, scratch.one->MBEDTLS_PRIVATE(p), scratch.one->MBEDTLS_PRIVATE(n), ctx->hw_words);
+    hw_start_mult();
+    ok = hw_read_result(ctx, Z, be_bytes);
+
+disable:
+    hw_disable();
+    exp_scratch_free(&scratch);
+    return ok;
+}
+
+bool rsa_mod_mult_hw_words(const rsa_mont_ctx_t *ctx, const uint32_t *X, const uint32_t *Y, uint32_t *Z) {
+    return mod_mult_raw(ctx, X, Y, Z, false);
+}
+
+bool rsa_mod_mult_hw_bytes(const rsa_mont_ctx_t *ctx, const uint8_t *X, const uint8_t *Y, uint8_t *Z) {
+    return mod_mult_raw(ctx, X, Y, Z, true);
+}
+
+bool rsa_mod_exp_hw_words(const rsa_mont_ctx_t *ctx, const uint32_t *X,
+                          const rsa_exp_plan_t *plan, uint32_t *Z, bool feed_wdt) {
+    (void)feed_wdt;
+    return mod_exp_raw(ctx, X, plan, Z, false);
+}
+
+bool rsa_mod_exp_hw_bytes(const rsa_mont_ctx_t *ctx, const uint8_t *X,
+                          const rsa_exp_plan_t *plan, uint8_t *Z, bool feed_wdt) {
+    (void)feed_wdt;
+    return mod_exp_raw(ctx, X, plan, Z, true);
+}
+
 bool rsa_mod_exp_hw_ctx(const rsa_mont_ctx_t *ctx,
                         const mbedtls_mpi *X, const mbedtls_mpi *E,
                         mbedtls_mpi *Z, bool feed_wdt) {
     if (!ctx || !X || !E || !Z) {
         return false;
     }
-    (void)feed_wdt;
-    if (mbedtls_mpi_cmp_int(E, 0) == 0) {
+
+    // Recode into the context's step buffer; only exponents longer than the
+    // modulus need a heap-allocated plan
+    rsa_exp_plan_t plan;
+    if (exp_plan_recode(&plan, E, 0, ctx->steps, ctx->step_capacity)) {
+        return rsa_mod_exp_hw_plan(ctx, X, &plan, Z, feed_wdt);
+    }
+    if (!rsa_exp_plan_init(&plan, E, 0)) {
+        return false;
+    }
+    bool ok = rsa_mod_exp_hw_plan(ctx, X, &plan, Z, feed_wdt);
+    rsa_exp_plan_free(&plan);
+    return ok;
+}
+
+// ==================== MULTI-EXPONENTIATION ====================
+
+// Interleaved sliding windows (Straus): every base keeps its own window
+// recoding and odd-power table, and all of them share one accumulator, so
+// the squarings are paid once for the longest exponent instead of per base.
+bool rsa_mod_multi_exp_hw_plans(const rsa_mont_ctx_t *ctx, const mbedtls_mpi *const *X,
+                                const rsa_exp_plan_t *const *plans, size_t count, mbedtls_mpi *Z) {
+    if (!ctx || !X || !plans || !Z || count == 0 || count > RSA_MULTI_EXP_MAX) {
+        return false;
+    }
+
+    size_t table_total = 0;
+    size_t table_base[RSA_MULTI_EXP_MAX];
+    size_t step[RSA_MULTI_EXP_MAX];
+    size_t pos[RSA_MULTI_EXP_MAX];
+    size_t top = 0;
+    bool any = false;
+    for (size_t b = 0; b < count; b++) {
+        const rsa_exp_plan_t *plan = plans[b];
+        if (!plan || plan->is_chain) {
+            return false;
+        }
+        table_base[b] = table_total;
+        table_total += plan->table_size;
+        step[b] = 0;
+        if (plan->step_count == 0) {
+            continue;
+        }
+        // Bit position of the first window; later ones follow by subtracting
+        // each step's squarings
+        pos[b] = plan->tail_squarings;
+        for (size_t i = 1; i < plan->step_count; i++) {
+            pos[b] += plan->steps[i].squarings;
+        }
+        if (!any || pos[b] > top) {
+            top = pos[b];
+        }
+        any = true;
+    }
+    if (!any) {
         return mbedtls_mpi_lset(Z, 1) == 0;
     }
+    if (mbedtls_mpi_grow(Z, ctx->hw_words) != 0) {
+        return false;
+    }
 
-    mbedtls_mpi X_mont;
-    mbedtls_mpi one;
-    mbedtls_mpi_init(&X_mont);
-    mbedtls_mpi_init(&one);
+    // All tables as views into one block, the accumulator and X^2 borrowed
+    // from the context arena
+    const size_t hw_words = ctx->hw_words;
+    uint32_t *mem = hw_calloc(table_total * hw_words, sizeof(uint32_t));
+    mbedtls_mpi *tables = hw_calloc(table_total, sizeof(mbedtls_mpi));
+    if (!mem || !tables) {
+        hw_free(mem);
+        hw_free(tables);
+        return false;
+    }
+    for (size_t r = 0; r < table_total; r++) {
+        tables[r].MBEDTLS_PRIVATE(s) = 1;
+        tables[r].MBEDTLS_PRIVATE(n) = hw_words;
+        tables[r].MBEDTLS_PRIVATE(p) = &mem[r * hw_words];
+    }
+    mbedtls_mpi *X2 = &ctx->scratch[ctx->scratch_regs];
+    mbedtls_mpi *acc = &ctx->scratch[ctx->scratch_regs + 1];
+
+    bool ok = false;
+    bool again = false;
+    hw_enable();
+
+    for (size_t b = 0; b < count; b++) {
+        mbedtls_mpi *T = &tables[table_base[b]];
+        if (plans[b]->step_count == 0) {
+            continue;
+        }
+        if (hw_mont(&T[0], X[b], &ctx->Rinv, &ctx->M, ctx->mprime, hw_words, again) != 0) {
+            goto disable;
+        }
+        again = true;
+        if (plans[b]->table_size > 1) {
+            if (hw_mont(X2, &T[0], &T[0], &ctx->M, ctx->mprime, hw_words, true) != 0) {
+                goto disable;
+            }
+            for (size_t k = 1; k < plans[b]->table_size; k++) {
+                if (hw_mont(&T[k], &T[k - 1], X2, &ctx->M, ctx->mprime, hw_words, true) != 0) {
+                    goto disable;
+                }
+            }
+        }
+    }
+
+    bool started = false;
+    for (size_t p = top + 1; p-- > 0;) {
+        if (started && hw_mont(acc, acc, acc, &ctx->M, ctx->mprime, hw_words, true) != 0) {
+            goto disable;
+        }
+        for (size_t b = 0; b < count; b++) {
+            const rsa_exp_plan_t *plan = plans[b];
+            if (step[b] >= plan->step_count || pos[b] != p) {
+                continue;
+            }
+            const mbedtls_mpi *T = &tables[table_base[b] + (plan->steps[step[b]].digit >> 1)];
+            if (!started) {
+                if (mbedtls_mpi_copy(acc, T) != 0) {
+                    goto disable;
+                }
+                started = true;
+            } else if (hw_mont(acc, acc, T, &ctx->M, ctx->mprime, hw_words, true) != 0) {
+                goto disable;
+            }
+            if (++step[b] < plan->step_count) {
+                pos[b] -= plan->steps[step[b]].squarings;
+            }
+        }
+    }
+
+    ok = hw_mont(Z, acc, &ctx->one, &ctx->M, ctx->mprime, hw_words, true) == 0;
+
+disable:
+    hw_disable();
+    hw_free(tables);
+    hw_free(mem);
+    return ok;
+}
 
-    if (mbedtls_mpi_grow(&X_mont, ctx->hw_words) != 0 ||
-        mbedtls_mpi_grow(Z, ctx->hw_words) != 0 ||
-        mbedtls_mpi_grow(&one, ctx->hw_words) != 0 ||
-        mbedtls_mpi_set_bit(&one, 0, 1) != 0) {
-        mbedtls_mpi_free(&X_mont);
-        mbedtls_mpi_free(&one);
+bool rsa_mod_multi_exp_hw(const rsa_mont_ctx_t *ctx, const mbedtls_mpi *const *X,
+                          const mbedtls_mpi *const *E, size_t count, mbedtls_mpi *Z) {
+    if (!E || count == 0 || count > RSA_MULTI_EXP_MAX) {
         return false;
     }
 
-    int t = (int)mpi_msb(E);
-    esp_mpi_enable_hardware_hw_op();
+    rsa_exp_plan_t plans[RSA_MULTI_EXP_MAX];
+    const rsa_exp_plan_t *plan_ptrs[RSA_MULTI_EXP_MAX];
+    size_t ready = 0;
+    bool ok = true;
+    for (; ready < count && ok; ready++) {
+        ok = rsa_exp_plan_init(&plans[ready], E[ready], 0);
+        plan_ptrs[ready] = &plans[ready];
+    }
+    if (ok) {
+        ok = rsa_mod_multi_exp_hw_plans(ctx, X, plan_ptrs, count, Z);
+    }
+    for (size_t b = 0; b < ready; b++) {
+        rsa_exp_plan_free(&plans[b]);
+    }
+    return ok;
+}
+
+// ==================== CRT EXPONENTIATION ====================
 
-    // X_mont = mont(X, R^2 mod M) = X * R mod M
-    if (esp_mont_hw_op(&X_mont, X, &ctx->Rinv, &ctx->M, ctx->mprime, ctx->hw_words, false) != 0) {
-        esp_mpi_disable_hardware_hw_op();
-        mbedtls_mpi_free(&X_mont);
-        mbedtls_mpi_free(&one);
+static bool crt_mont_init(rsa_mont_ctx_t *ctx, const mbedtls_mpi *P) {
+    size_t words = (mbedtls_mpi_bitlen(P) + 31) / 32;
+    return words > 0 && rsa_mont_ctx_init(ctx, P->MBEDTLS_PRIVATE(p), words);
+}
+
+bool rsa_crt_ctx_init(rsa_crt_ctx_t *crt, const mbedtls_mpi *P, const mbedtls_mpi *Q, const mbedtls_mpi *D) {
+    if (!crt || !P || !Q || !D) {
         return false;
     }
+    memset(crt, 0, sizeof(*crt));
+    mbedtls_mpi_init(&crt->P);
+    mbedtls_mpi_init(&crt->Q);
+    mbedtls_mpi_init(&crt->DP);
+    mbedtls_mpi_init(&crt->DQ);
+    mbedtls_mpi_init(&crt->QP);
+
+    mbedtls_mpi T;
+    mbedtls_mpi_init(&T);
+    bool ok = mbedtls_mpi_copy(&crt->P, P) == 0 &&
+              mbedtls_mpi_copy(&crt->Q, Q) == 0 &&
+              // DP = D mod (P - 1), DQ = D mod (Q - 1), QP = Q^-1 mod P
+              mbedtls_mpi_sub_int(&T, P, 1) == 0 &&
+              mbedtls_mpi_mod_mpi(&crt->DP, D, &T) == 0 &&
+              mbedtls_mpi_sub_int(&T, Q, 1) == 0 &&
+              mbedtls_mpi_mod_mpi(&crt->DQ, D, &T) == 0 &&
+              mbedtls_mpi_inv_mod(&crt->QP, Q, P) == 0 &&
+              mbedtls_mpi_mul_mpi(&T, P, Q) == 0;
+    if (ok) {
+        crt->bits = mbedtls_mpi_bitlen(&T);
+    }
+    mbedtls_mpi_free(&T);
 
-    // Z = R mod M
-    if (esp_mont_hw_op(Z, &ctx->Rinv, &one, &ctx->M, ctx->mprime, ctx->hw_words, true) != 0) {
-        esp_mpi_disable_hardware_hw_op();
-        mbedtls_mpi_free(&X_mont);
-        mbedtls_mpi_free(&one);
+    ok = ok && crt_mont_init(&crt->p_ctx, P);
+    crt->p_ready = ok;
+    ok = ok && crt_mont_init(&crt->q_ctx, Q);
+    crt->q_ready = ok;
+    ok = ok && rsa_exp_plan_init(&crt->dp_plan, &crt->DP, 0) &&
+         rsa_exp_plan_init(&crt->dq_plan, &crt->DQ, 0);
+    if (!ok) {
+        rsa_crt_ctx_free(crt);
+    }
+    return ok;
+}
+
+void rsa_crt_ctx_free(rsa_crt_ctx_t *crt) {
+    if (!crt) {
+        return;
+    }
+    if (crt->p_ready) {
+        rsa_mont_ctx_free(&crt->p_ctx);
+    }
+    if (crt->q_ready) {
+        rsa_mont_ctx_free(&crt->q_ctx);
+    }
+    rsa_exp_plan_free(&crt->dp_plan);
+    rsa_exp_plan_free(&crt->dq_plan);
+    mbedtls_mpi_free(&crt->P);
+    mbedtls_mpi_free(&crt->Q);
+    mbedtls_mpi_free(&crt->DP);
+    mbedtls_mpi_free(&crt->DQ);
+    mbedtls_mpi_free(&crt->QP);
+    crt->p_ready = false;
+    crt->q_ready = false;
+}
+
+// Z = X^D mod PQ as two half-size exponentiations, recombined with Garner:
+// Z = mq + Q * (QP * (mp - mq) mod P).
+bool rsa_mod_exp_crt(const rsa_crt_ctx_t *crt, const mbedtls_mpi *X, mbedtls_mpi *Z) {
+    if (!crt || !X || !Z) {
         return false;
     }
 
-    for (int i = t; i >= 0; i--) {
-        if (i != t) {
-            if (esp_mont_hw_op(Z, Z, Z, &ctx->M, ctx->mprime, ctx->hw_words, true) != 0) {
-                esp_mpi_disable_hardware_hw_op();
-                mbedtls_mpi_free(&X_mont);
-                mbedtls_mpi_free(&one);
+    mbedtls_mpi Xp, Xq, mp, mq, h;
+    mbedtls_mpi_init(&Xp);
+    mbedtls_mpi_init(&Xq);
+    mbedtls_mpi_init(&mp);
+    mbedtls_mpi_init(&mq);
+    mbedtls_mpi_init(&h);
+
+    bool ok = mbedtls_mpi_mod_mpi(&Xp, X, &crt->P) == 0 &&
+              mbedtls_mpi_mod_mpi(&Xq, X, &crt->Q) == 0 &&
+              rsa_mod_exp_hw_plan(&crt->p_ctx, &Xp, &crt->dp_plan, &mp, false) &&
+              rsa_mod_exp_hw_plan(&crt->q_ctx, &Xq, &crt->dq_plan, &mq, false);
+
+    // h = (mp - mq) mod P, then QP * h mod P on the P context
+    ok = ok && mbedtls_mpi_sub_mpi(&h, &mp, &mq) == 0 &&
+         mbedtls_mpi_mod_mpi(&h, &h, &crt->P) == 0 &&
+         rsa_mod_mult_hw_ctx(&crt->p_ctx, &h, &crt->QP, &h) &&
+         mbedtls_mpi_mod_mpi(&h, &h, &crt->P) == 0 &&
+         mbedtls_mpi_mul_mpi(&h, &h, &crt->Q) == 0 &&
+         mbedtls_mpi_add_mpi(Z, &h, &mq) == 0;
+
+    mbedtls_mpi_free(&Xp);
+    mbedtls_mpi_free(&Xq);
+    mbedtls_mpi_free(&mp);
+    mbedtls_mpi_free(&mq);
+    mbedtls_mpi_free(&h);
+    return ok;
+}
+
+// ==================== FIXED-BASE EXPONENTIATION ====================
+
+static mbedtls_mpi *fixed_base_entry(const rsa_fixed_base_ctx_t *fb, size_t j) {
+    return &fb->table[j - 1];
+}
+
+bool rsa_fixed_base_init(rsa_fixed_base_ctx_t *fb, const rsa_mont_ctx_t *ctx, const mbedtls_mpi *G,
+                         size_t max_bits, size_t teeth, uint32_t caps) {
+    if (!fb || !ctx || !G || max_bits == 0 || teeth == 0 || teeth > RSA_FIXED_BASE_MAX_TEETH) {
+        return false;
+    }
+    memset(fb, 0, sizeof(*fb));
+    fb->ctx = ctx;
+    fb->teeth = teeth;
+    fb->max_bits = max_bits;
+    fb->spacing = (max_bits + teeth - 1) / teeth;
+    fb->entries = ((size_t)1 << teeth) - 1;
+
+    const size_t hw_words = ctx->hw_words;
+    fb->table_mem = hw_calloc_caps(fb->entries * hw_words, sizeof(uint32_t), caps);
+    fb->table = hw_calloc(fb->entries, sizeof(mbedtls_mpi));
+    if (!fb->table_mem || !fb->table) {
+        rsa_fixed_base_free(fb);
+        return false;
+    }
+    // Entries are views into one block so the table can live in whatever
+    // memory `caps` selects; they are never grown or freed individually.
+    for (size_t j = 1; j <= fb->entries; j++) {
+        mbedtls_mpi *T = fixed_base_entry(fb, j);
+        T->MBEDTLS_PRIVATE(s) = 1;
+        T->MBEDTLS_PRIVATE(n) = hw_words;
+        T->MBEDTLS_PRIVATE(p) = &fb->table_mem[(j - 1) * hw_words];
+    }
+
+    bool ok = false;
+    hw_enable();
+
+    // entry(2^i) = G^(2^(i*spacing)) in Montgomery form
+    if (hw_mont(fixed_base_entry(fb, 1), G, &ctx->Rinv, &ctx->M, ctx->mprime, hw_words, false) != 0) {
+        goto disable;
+    }
+    fb->precomp_montmuls = 1;
+    for (size_t i = 1; i < teeth; i++) {
+        mbedtls_mpi *T = fixed_base_entry(fb, (size_t)1 << i);
+        const mbedtls_mpi *prev = fixed_base_entry(fb, (size_t)1 << (i - 1));
+        for (size_t k = 0; k < fb->spacing; k++) {
+            if (hw_mont(T, prev, prev, &ctx->M, ctx->mprime, hw_words, true) != 0) {
+                goto disable;
+            }
+            prev = T;
+        }
+        fb->precomp_montmuls += fb->spacing;
+    }
+
+    // Every other entry is one product of two earlier ones
+    for (size_t j = 3; j <= fb->entries; j++) {
+        size_t low = j & (~j + 1);
+        if (low == j) {
+            continue;
+        }
+        if (hw_mont(fixed_base_entry(fb, j), fixed_base_entry(fb, j - low), fixed_base_entry(fb, low),
+                           &ctx->M, ctx->mprime, hw_words, true) != 0) {
+            goto disable;
+        }
+        fb->precomp_montmuls++;
+    }
+    ok = true;
+
+disable:
+    hw_disable();
+    if (!ok) {
+        rsa_fixed_base_free(fb);
+    }
+    return ok;
+}
+
+void rsa_fixed_base_free(rsa_fixed_base_ctx_t *fb) {
+    if (!fb) {
+        return;
+    }
+    hw_free(fb->table);
+    hw_free(fb->table_mem);
+    fb->table = NULL;
+    fb->table_mem = NULL;
+    fb->entries = 0;
+}
+
+size_t rsa_fixed_base_table_bytes(const rsa_fixed_base_ctx_t *fb) {
+    return fb->entries * fb->ctx->hw_words * sizeof(uint32_t);
+}
+
+// Comb evaluation: column k of the exponent, read at bits k, k + spacing,
+// k + 2*spacing, ..., indexes the table, so the whole exponent costs
+// spacing - 1 squarings plus one multiply per non-zero column.
+bool rsa_fixed_base_exp(const rsa_fixed_base_ctx_t *fb, const mbedtls_mpi *E, mbedtls_mpi *Z) {
+    if (!fb || !fb->table || !E || !Z) {
+        return false;
+    }
+    if (mbedtls_mpi_bitlen(E) > fb->max_bits) {
+        return false;
+    }
+    if (mbedtls_mpi_cmp_int(E, 0) == 0) {
+        return mbedtls_mpi_lset(Z, 1) == 0;
+    }
+
+    const rsa_mont_ctx_t *ctx = fb->ctx;
+    mbedtls_mpi *acc = &ctx->scratch[ctx->scratch_regs + 1];
+    if (mbedtls_mpi_grow(Z, ctx->hw_words) != 0) {
+        return false;
+    }
+
+    bool ok = false;
+    bool started = false;
+    bool again = false;
+    hw_enable();
+
+    for (size_t k = fb->spacing; k-- > 0;) {
+        size_t idx = 0;
+        for (size_t i = 0; i < fb->teeth; i++) {
+            idx |= (size_t)mbedtls_mpi_get_bit(E, i * fb->spacing + k) << i;
+        }
+        if (started) {
+            if (hw_mont(acc, acc, acc, &ctx->M, ctx->mprime, ctx->hw_words, again) != 0) {
+                goto disable;
+            }
+            again = true;
+        }
+        if (idx == 0) {
+            continue;
+        }
+        if (!started) {
+            if (mbedtls_mpi_copy(acc, fixed_base_entry(fb, idx)) != 0) {
+                goto disable;
+            }
+            started = true;
+        } else {
+            if (hw_mont(acc, acc, fixed_base_entry(fb, idx), &ctx->M, ctx->mprime, ctx->hw_words, again) != 0) {
+                goto disable;
+            }
+            again = true;
+        }
+    }
+
+    ok = hw_mont(Z, acc, &ctx->one, &ctx->M, ctx->mprime, ctx->hw_words, again) == 0;
+
+disable:
+    hw_disable();
+    return ok;
+}
+
+// ==================== BATCH VERIFICATION ====================
+
+typedef struct {
+    const rsa_mont_ctx_t *ctx;
+    const rsa_exp_plan_t *plan;
+    const mbedtls_mpi *const *X;
+    const mbedtls_mpi *const *Y;
+    size_t buckets_count;        // 2^mult_bits - 1, multipliers run 1..buckets_count
+    uint8_t *r;                  // per-item multiplier, 0 for items rejected up front
+    uint8_t *filled;             // per-bucket flag
+    mbedtls_mpi *buckets;        // views, bucket d at buckets[d - 1]
+    mbedtls_mpi *tmp;
+    mbedtls_mpi *running;
+    mbedtls_mpi *lhs;
+    mbedtls_mpi *rhs;
+    exp_scratch_t scratch;
+    bool *valid;
+    size_t rejected;
+    bool again;
+} batch_verify_t;
+
+static bool bv_mont(batch_verify_t *bv, mbedtls_mpi *Z, const mbedtls_mpi *A, const mbedtls_mpi *B) {
+    const rsa_mont_ctx_t *ctx = bv->ctx;
+    bool ok = hw_mont(Z, A, B, &ctx->M, ctx->mprime, ctx->hw_words, bv->again) == 0;
+    bv->again = true;
+    return ok;
+}
+
+static void bv_mark(batch_verify_t *bv, size_t lo, size_t n, bool good) {
+    for (size_t i = lo; i < lo + n; i++) {
+        if (bv->r[i] == 0) {
+            continue;
+        }
+        if (!good) {
+            bv->rejected++;
+        }
+        if (bv->valid) {
+            bv->valid[i] = good;
+        }
+    }
+}
+
+// out = prod V[i]^r[i] over the range, in Montgomery form. Items are
+// dropped into the bucket of their multiplier (one conversion and one
+// multiply each), then the buckets are combined by running products:
+// prod_d B_d^d costs two multiplies per bucket regardless of the batch size.
+static bool bv_side(batch_verify_t *bv, const mbedtls_mpi *const *V, size_t lo, size_t n, mbedtls_mpi *out) {
+    const rsa_mont_ctx_t *ctx = bv->ctx;
+    memset(bv->filled, 0, bv->buckets_count);
+
+    for (size_t i = lo; i < lo + n; i++) {
+        uint8_t d = bv->r[i];
+        if (d == 0) {
+            continue;
+        }
+        mbedtls_mpi *B = &bv->buckets[d - 1];
+        if (!bv->filled[d - 1]) {
+            if (!bv_mont(bv, B, V[i], &ctx->Rinv)) {
                 return false;
             }
+            bv->filled[d - 1] = 1;
+        } else if (!bv_mont(bv, bv->tmp, V[i], &ctx->Rinv) || !bv_mont(bv, B, B, bv->tmp)) {
+            return false;
         }
+    }
 
-        if (mbedtls_mpi_get_bit(E, i)) {
-            if (esp_mont_hw_op(Z, Z, &X_mont, &ctx->M, ctx->mprime, ctx->hw_words, true) != 0) {
-                esp_mpi_disable_hardware_hw_op();
-                mbedtls_mpi_free(&X_mont);
-                mbedtls_mpi_free(&one);
+    bool run_started = false;
+    bool out_started = false;
+    for (size_t d = bv->buckets_count; d > 0; d--) {
+        if (bv->filled[d - 1]) {
+            if (!run_started) {
+                if (mbedtls_mpi_copy(bv->running, &bv->buckets[d - 1]) != 0) {
+                    return false;
+                }
+                run_started = true;
+            } else if (!bv_mont(bv, bv->running, bv->running, &bv->buckets[d - 1])) {
+                return false;
+            }
+        }
+        if (!run_started) {
+            continue;
+        }
+        if (!out_started) {
+            if (mbedtls_mpi_copy(out, bv->running) != 0) {
                 return false;
             }
+            out_started = true;
+        } else if (!bv_mont(bv, out, out, bv->running)) {
+            return false;
         }
     }
+    // An empty range multiplies to one
+    return out_started || (mbedtls_mpi_copy(out, &ctx->Rinv) == 0 && bv_mont(bv, out, out, &ctx->one));
+}
 
-    // Convert back from Montgomery domain
-    if (esp_mont_hw_op(Z, Z, &one, &ctx->M, ctx->mprime, ctx->hw_words, true) != 0) {
-        esp_mpi_disable_hardware_hw_op();
-        mbedtls_mpi_free(&X_mont);
-        mbedtls_mpi_free(&one);
+// *pass = (prod X^r)^e == prod Y^r with fresh multipliers for the range
+static bool bv_test(batch_verify_t *bv, size_t lo, size_t n, bool *pass) {
+    for (size_t i = lo; i < lo + n; i++) {
+        if (bv->r[i] != 0) {
+            bv->r[i] = (uint8_t)(1 + esp_random() % bv->buckets_count);
+        }
+    }
+    if (!bv_side(bv, bv->X, lo, n, bv->lhs) || !bv_side(bv, bv->Y, lo, n, bv->rhs)) {
+        return false;
+    }
+    if (mbedtls_mpi_copy(&bv->scratch.regs[0], bv->lhs) != 0) {
+        return false;
+    }
+    const mbedtls_mpi *lhs_e = exp_body_locked(bv->ctx, bv->plan, &bv->scratch);
+    if (!lhs_e) {
         return false;
     }
+    *pass = mbedtls_mpi_cmp_mpi(lhs_e, bv->rhs) == 0;
+    return true;
+}
 
-    esp_mpi_disable_hardware_hw_op();
-    mbedtls_mpi_free(&X_mont);
-    mbedtls_mpi_free(&one);
+// Exact check of one item, both sides in Montgomery form
+static bool bv_single(batch_verify_t *bv, size_t i, bool *pass) {
+    const rsa_mont_ctx_t *ctx = bv->ctx;
+    if (!bv_mont(bv, &bv->scratch.regs[0], bv->X[i], &ctx->Rinv) ||
+        !bv_mont(bv, bv->rhs, bv->Y[i], &ctx->Rinv)) {
+        return false;
+    }
+    const mbedtls_mpi *lhs_e = exp_body_locked(ctx, bv->plan, &bv->scratch);
+    if (!lhs_e) {
+        return false;
+    }
+    *pass = mbedtls_mpi_cmp_mpi(lhs_e, bv->rhs) == 0;
     return true;
 }
 
+// Bisects a failing range. A failed test proves the range holds a bad item
+// (an all-good range always passes), so when the left half passes the
+// right half is split without testing it again. A pass is not proof,
+// though: the bad item may have slipped through the left half's test, and
+// the right half is then all good. Single items are therefore always
+// checked exactly, so a valid item is never rejected on inference alone.
+// *all_good reports whether every item of the range that reached the test
+// verified.
+static bool bv_range(batch_verify_t *bv, size_t lo, size_t n, bool known_bad, bool *all_good) {
+    bool pass = false;
+    if (n == 1) {
+        if (bv->r[lo] == 0) {
+            // Rejected up front; an empty range counts as verified
+            *all_good = true;
+            return true;
+        }
+        if (!bv_single(bv, lo, &pass)) {
+            return false;
+        }
+        bv_mark(bv, lo, 1, pass);
+        *all_good = pass;
+        return true;
+    }
+    if (!known_bad) {
+        if (!bv_test(bv, lo, n, &pass)) {
+            return false;
+        }
+        if (pass) {
+            bv_mark(bv, lo, n, true);
+            *all_good = true;
+            return true;
+        }
+    }
+
+    size_t half = n / 2;
+    bool left_good = false;
+    bool right_good = false;
+    if (!bv_range(bv, lo, half, false, &left_good) ||
+        !bv_range(bv, lo + half, n - half, left_good, &right_good)) {
+        return false;
+    }
+    *all_good = false;
+    return true;
+}
+
+bool rsa_batch_verify(const rsa_mont_ctx_t *ctx, const rsa_exp_plan_t *plan,
+                      const mbedtls_mpi *const *X, const mbedtls_mpi *const *Y, size_t count,
+                      size_t mult_bits, bool *valid, size_t *rejected) {
+    if (!ctx || !plan || !X || !Y || !rejected || exp_plan_is_empty(plan) ||
+        mult_bits < 2 || mult_bits > RSA_BATCH_VERIFY_MAX_BITS) {
+        return false;
+    }
+    *rejected = 0;
+    if (count == 0) {
+        return true;
+    }
+
+    batch_verify_t bv = {
+        .ctx = ctx,
+        .plan = plan,
+        .X = X,
+        .Y = Y,
+        .buckets_count = ((size_t)1 << mult_bits) - 1,
+        .valid = valid,
+    };
+    if (!exp_scratch_init(&bv.scratch, ctx, plan)) {
+        return false;
+    }
+
+    const size_t hw_words = ctx->hw_words;
+    const size_t views = bv.buckets_count + 4;
+    uint32_t *mem = hw_calloc(views * hw_words, sizeof(uint32_t));
+    mbedtls_mpi *regs = hw_calloc(views, sizeof(mbedtls_mpi));
+    bv.r = hw_calloc(count + bv.buckets_count, 1);
+    if (!mem || !regs || !bv.r) {
+        hw_free(mem);
+        hw_free(regs);
+        hw_free(bv.r);
+        exp_scratch_free(&bv.scratch);
+        return false;
+    }
+    for (size_t k = 0; k < views; k++) {
+        regs[k].MBEDTLS_PRIVATE(s) = 1;
+        regs[k].MBEDTLS_PRIVATE(n) = hw_words;
+        regs[k].MBEDTLS_PRIVATE(p) = &mem[k * hw_words];
+    }
+    bv.buckets = regs;
+    bv.tmp = &regs[bv.buckets_count];
+    bv.running = &regs[bv.buckets_count + 1];
+    bv.lhs = &regs[bv.buckets_count + 2];
+    bv.rhs = &regs[bv.buckets_count + 3];
+    bv.filled = &bv.r[count];
+
+    // Unreduced operands would be folded mod M by the multiplies and could
+    // pass the product test, so they are rejected before it
+    for (size_t i = 0; i < count; i++) {
+        bool reduced = mbedtls_mpi_cmp_mpi(X[i], &ctx->M) < 0 && mbedtls_mpi_cmp_mpi(Y[i], &ctx->M) < 0 &&
+                       mbedtls_mpi_cmp_int(X[i], 0) >= 0 && mbedtls_mpi_cmp_int(Y[i], 0) >= 0;
+        if (reduced) {
+            bv.r[i] = 1;
+        } else {
+            bv.rejected++;
+            if (valid) {
+                valid[i] = false;
+            }
+        }
+    }
+
+    bool all_good = false;
+    hw_enable();
+    bool ok = bv_range(&bv, 0, count, false, &all_good);
+    hw_disable();
+
+    *rejected = bv.rejected;
+    hw_free(bv.r);
+    hw_free(regs);
+    hw_free(mem);
+    exp_scratch_free(&bv.scratch);
+    return ok;
+}
+
 void generate_random_4096_odd(uint32_t *num) {
     uint8_t *bytes = (uint8_t *)num;
     
@@ -229,9 +1709,9 @@ bool is_zero_4096(const uint32_t *num) {
 
 void rsa_periph_enable(bool enable) {
     if (enable) {
-        esp_mpi_enable_hardware_hw_op();
+        hw_enable();
     } else {
-        esp_mpi_disable_hardware_hw_op();
+        hw_disable();
     }
 }
 
@@ -4,7 +4,6 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
-#include "soc/hwcrypto_reg.h"
 #include "mbedtls/bignum.h"
 
 // 4096-bit configuration
@@ -32,18 +31,71 @@ bool rsa_mod_exp_hw(const uint32_t *X, const uint32_t *E,
                     const uint32_t *M, uint32_t *Z);
 bool verify_hw_sw_small_mult(size_t iterations);
 bool verify_hw_sw_small_exp(size_t iterations);
+bool verify_hw_sw_full(size_t bits, size_t iterations);
 
+typedef struct {
+    uint16_t squarings;  // squarings before the multiply
+    uint16_t digit;      // odd window value, multiply by X^digit
+} rsa_exp_step_t;
+
+// Per-modulus context. Init allocates everything an exponentiation with
+// this modulus needs (a padded 1, the window table and a step buffer), so the
+// steady-state mult/exp paths make no heap calls.
+//
+// One task per context: the mult/exp entry points take the context as
+// const because the modulus and its constants never change after init, but
+// they write the scratch arena and the step buffer on every call (as do
+// rsa_async and the fixed-base and batch paths built on it). Two tasks that
+// share a modulus need a context each, or their own lock around every call.
 typedef struct {
     size_t words;
     size_t hw_words;
     uint32_t mprime;
     mbedtls_mpi M;
     mbedtls_mpi Rinv;
+    mbedtls_mpi one;             // plain 1, padded to hw_words
+    mbedtls_mpi *scratch;        // scratch_regs table entries, then X^2 and acc
+    size_t scratch_regs;
+    rsa_exp_step_t *steps;       // recoding buffer for rsa_mod_exp_hw_ctx
+    size_t step_capacity;
 } rsa_mont_ctx_t;
 
 bool rsa_mont_ctx_init(rsa_mont_ctx_t *ctx, const uint32_t *M_words, size_t words);
 void rsa_mont_ctx_free(rsa_mont_ctx_t *ctx);
 
+// Heap calls made by this module, plus mbedtls's own once the counting
+// calloc/free hook is installed (needs MBEDTLS_PLATFORM_MEMORY).
+void rsa_heap_counter_install(void);
+size_t rsa_heap_calls(void);
+
+// Accelerator work done by this module: hardware montmuls (squarings are
+// the ones with both operands the same mpi), peripheral enable/disable
+// pairs, operand and modulus loads into the memory blocks, result reads
+// and the bytes those loads and reads move. Build with
+// -DRSA_HW_OP_COUNTERS=0 to compile the updates out; the counts then
+// stay zero.
+#ifndef RSA_HW_OP_COUNTERS
+#define RSA_HW_OP_COUNTERS 1
+#endif
+
+typedef struct {
+    size_t montmuls;
+    size_t squarings;
+    size_t enables;
+    size_t disables;
+    size_t operand_loads;
+    size_t modulus_loads;
+    size_t result_reads;
+    size_t bytes_copied;
+} rsa_hw_op_counts_t;
+
+// Cumulative since the last reset; take two snapshots and subtract them
+// for one call, or reset at the start of a suite.
+void rsa_hw_op_counts_get(rsa_hw_op_counts_t *out);
+void rsa_hw_op_counts_reset(void);
+void rsa_hw_op_counts_sub(rsa_hw_op_counts_t *acc, const rsa_hw_op_counts_t *after,
+                          const rsa_hw_op_counts_t *before);
+
 bool rsa_mpi_set_words(mbedtls_mpi *X, const uint32_t *words, size_t n_words);
 void rsa_mpi_get_words(const mbedtls_mpi *X, uint32_t *words, size_t n_words);
 
@@ -54,11 +106,157 @@ bool rsa_mod_exp_hw_ctx(const rsa_mont_ctx_t *ctx,
                         const mbedtls_mpi *X, const mbedtls_mpi *E,
                         mbedtls_mpi *Z, bool feed_wdt);
 
+// Operand held in Montgomery form (value * R mod M) for a given context.
+// Chains of multiplies stay in this form and only convert at the edges.
+typedef struct {
+    mbedtls_mpi v;
+} rsa_mont_elem_t;
+
+void rsa_mont_elem_init(rsa_mont_elem_t *A);
+void rsa_mont_elem_free(rsa_mont_elem_t *A);
+bool rsa_mont_to_mont(const rsa_mont_ctx_t *ctx, const mbedtls_mpi *X, rsa_mont_elem_t *A);
+bool rsa_mont_from_mont(const rsa_mont_ctx_t *ctx, const rsa_mont_elem_t *A, mbedtls_mpi *X);
+bool rsa_mont_mul(const rsa_mont_ctx_t *ctx, const rsa_mont_elem_t *A,
+                  const rsa_mont_elem_t *B, rsa_mont_elem_t *Z);
+bool rsa_mont_sqr(const rsa_mont_ctx_t *ctx, const rsa_mont_elem_t *A, rsa_mont_elem_t *Z);
+
+// Sliding-window exponent plan. Recode once per exponent and reuse it for
+// every exponentiation with that exponent. Steps are defined above.
+
+// Straight-line addition-chain op: reg[dst] = reg[a] * reg[b]. reg[0]
+// starts as X in Montgomery form.
+#define RSA_EXP_CHAIN_REGS 3
+
+typedef struct {
+    uint8_t dst;
+    uint8_t a;
+    uint8_t b;
+} rsa_exp_op_t;
+
+typedef struct {
+    size_t window;
+    size_t table_size;      // odd powers X^1, X^3, ..., X^(2*table_size-1)
+    size_t step_count;
+    size_t tail_squarings;
+    rsa_exp_step_t *steps;
+    // Addition-chain plans (rsa_exp_plan_init_chain) use these instead
+    bool is_chain;
+    size_t op_count;
+    uint8_t result_reg;
+    rsa_exp_op_t *ops;
+} rsa_exp_plan_t;
+
+size_t rsa_exp_window_size(size_t exp_bits);
+bool rsa_exp_plan_init(rsa_exp_plan_t *plan, const mbedtls_mpi *E, size_t window);
+bool rsa_exp_plan_init_chain(rsa_exp_plan_t *plan, uint32_t e);
+void rsa_exp_plan_free(rsa_exp_plan_t *plan);
+size_t rsa_exp_plan_montmuls(const rsa_exp_plan_t *plan);
+bool rsa_mod_exp_hw_plan(const rsa_mont_ctx_t *ctx,
+                         const mbedtls_mpi *X, const rsa_exp_plan_t *plan,
+                         mbedtls_mpi *Z, bool feed_wdt);
+
+// Batched entry points: the peripheral is enabled once for the whole batch.
+// Entries are pointers so a batch may reuse the same operand several times.
+bool rsa_mod_mult_hw_batch(const rsa_mont_ctx_t *ctx,
+                           const mbedtls_mpi *const *X, const mbedtls_mpi *const *Y,
+                           mbedtls_mpi *const *Z, size_t count);
+bool rsa_mod_exp_hw_batch(const rsa_mont_ctx_t *ctx,
+                          const mbedtls_mpi *const *X, const rsa_exp_plan_t *plan,
+                          mbedtls_mpi *const *Z, size_t count, bool feed_wdt);
+
+// Zero-copy hot path: operands are ctx->words little-endian words, or
+// ctx->words * 4 big-endian (wire format) bytes. They are written straight
+// into the RSA memory blocks and results are read straight back into the
+// caller's buffer, with no mbedtls_mpi in between.
+bool rsa_mod_mult_hw_words(const rsa_mont_ctx_t *ctx, const uint32_t *X, const uint32_t *Y, uint32_t *Z);
+bool rsa_mod_mult_hw_bytes(const rsa_mont_ctx_t *ctx, const uint8_t *X, const uint8_t *Y, uint8_t *Z);
+bool rsa_mod_exp_hw_words(const rsa_mont_ctx_t *ctx, const uint32_t *X,
+                          const rsa_exp_plan_t *plan, uint32_t *Z, bool feed_wdt);
+bool rsa_mod_exp_hw_bytes(const rsa_mont_ctx_t *ctx, const uint8_t *X,
+                          const rsa_exp_plan_t *plan, uint8_t *Z, bool feed_wdt);
+
+// Simultaneous exponentiation: Z = X[0]^E[0] * ... * X[count-1]^E[count-1]
+// mod M for up to RSA_MULTI_EXP_MAX bases, sharing the squarings. The
+// _plans form takes sliding-window plans (not addition chains).
+#define RSA_MULTI_EXP_MAX 4
+
+bool rsa_mod_multi_exp_hw(const rsa_mont_ctx_t *ctx, const mbedtls_mpi *const *X,
+                          const mbedtls_mpi *const *E, size_t count, mbedtls_mpi *Z);
+bool rsa_mod_multi_exp_hw_plans(const rsa_mont_ctx_t *ctx, const mbedtls_mpi *const *X,
+                                const rsa_exp_plan_t *const *plans, size_t count, mbedtls_mpi *Z);
+
+// Private-key exponentiation with the factors of the modulus known: two
+// half-size exponentiations (D mod P-1, D mod Q-1) on their own contexts,
+// recombined with Garner's formula using QP = Q^-1 mod P.
+typedef struct {
+    rsa_mont_ctx_t p_ctx;
+    rsa_mont_ctx_t q_ctx;
+    mbedtls_mpi P;
+    mbedtls_mpi Q;
+    mbedtls_mpi DP;
+    mbedtls_mpi DQ;
+    mbedtls_mpi QP;
+    rsa_exp_plan_t dp_plan;
+    rsa_exp_plan_t dq_plan;
+    size_t bits;                 // bit length of P * Q
+    bool p_ready;
+    bool q_ready;
+} rsa_crt_ctx_t;
+
+bool rsa_crt_ctx_init(rsa_crt_ctx_t *crt, const mbedtls_mpi *P, const mbedtls_mpi *Q, const mbedtls_mpi *D);
+void rsa_crt_ctx_free(rsa_crt_ctx_t *crt);
+bool rsa_mod_exp_crt(const rsa_crt_ctx_t *crt, const mbedtls_mpi *X, mbedtls_mpi *Z);
+
+// Fixed-base exponentiation (comb method). The table holds, in Montgomery
+// form, every product of G^(2^(i*spacing)) over subsets of the `teeth`
+// rows, so an exponent of up to max_bits bits costs about spacing
+// squarings plus as many multiplies. The table has 2^teeth - 1 entries of
+// hw_words words each and is allocated with `caps` (e.g. MALLOC_CAP_SPIRAM).
+#define RSA_FIXED_BASE_MAX_TEETH 10
+
+typedef struct {
+    const rsa_mont_ctx_t *ctx;
+    size_t teeth;
+    size_t spacing;              // ceil(max_bits / teeth)
+    size_t max_bits;
+    size_t entries;
+    uint32_t *table_mem;
+    mbedtls_mpi *table;          // views into table_mem, entry j at table[j - 1]
+    size_t precomp_montmuls;
+} rsa_fixed_base_ctx_t;
+
+bool rsa_fixed_base_init(rsa_fixed_base_ctx_t *fb, const rsa_mont_ctx_t *ctx, const mbedtls_mpi *G,
+                         size_t max_bits, size_t teeth, uint32_t caps);
+void rsa_fixed_base_free(rsa_fixed_base_ctx_t *fb);
+size_t rsa_fixed_base_table_bytes(const rsa_fixed_base_ctx_t *fb);
+bool rsa_fixed_base_exp(const rsa_fixed_base_ctx_t *fb, const mbedtls_mpi *E, mbedtls_mpi *Z);
+
+// Batch verification of Y[i] == X[i]^e mod M for a shared exponent plan
+// (small-exponents test): with random multipliers r_i of mult_bits bits,
+// checks (prod X[i]^r_i)^e == prod Y[i]^r_i using bucketed montmuls and a
+// single exponentiation. The test is a screen, not a proof: a bad item
+// Y[i] = z * X[i]^e passes whenever z^r_i == 1, which for an error z of
+// small order d happens for about 1/p of the multipliers, p the smallest
+// prime factor of d. Z_M^* has such elements (z = -1 passes for every even
+// r_i, about half the time), so 2^-mult_bits is only the bound for errors
+// without small-order factors. A failing batch is bisected, and single
+// items are checked exactly. valid[] (optional) receives the per-item
+// verdict and *rejected the number of items found bad. Returns false only
+// on errors.
+#define RSA_BATCH_VERIFY_MAX_BITS 8
+
+bool rsa_batch_verify(const rsa_mont_ctx_t *ctx, const rsa_exp_plan_t *plan,
+                      const mbedtls_mpi *const *X, const mbedtls_mpi *const *Y, size_t count,
+                      size_t mult_bits, bool *valid, size_t *rejected);
+
 // Debug functions
 void print_rsa_registers(const char* label);
 void debug_simple_hardware_test(void);
 
 // Benchmarks
-void benchmark_suite_fixed_mod(size_t bits, size_t iter_mult, size_t iter_exp_small, size_t iter_exp_full);
+void benchmark_suite_fixed_mod(size_t bits, size_t iter_mult, size_t iter_exp_small, size_t iter_exp_full,
+                               size_t iter_exp_variants);
+void benchmark_engines(size_t bits, size_t iter_mult, size_t iter_exp);
+void benchmark_size_sweep(size_t iter_mult, size_t iter_exp);
 
 #endif // RSA_HW_H_HW_H
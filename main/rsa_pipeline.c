@@ -0,0 +1,211 @@
+#include "rsa_pipeline.h"
+
+#include <string.h>
+
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define PIPELINE_STACK_BYTES 4096
+#define PIPELINE_PRIORITY 5
+
+bool rsa_spsc_init(rsa_spsc_ring_t *ring, size_t capacity, size_t slot_words) {
+    if (!ring || capacity == 0 || (capacity & (capacity - 1)) != 0 || slot_words == 0) {
+        return false;
+    }
+    ring->slots = heap_caps_calloc(capacity * slot_words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    if (!ring->slots) {
+        return false;
+    }
+    ring->slot_words = slot_words;
+    ring->capacity = capacity;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    return true;
+}
+
+void rsa_spsc_free(rsa_spsc_ring_t *ring) {
+    if (!ring) {
+        return;
+    }
+    heap_caps_free(ring->slots);
+    ring->slots = NULL;
+    ring->capacity = 0;
+}
+
+// Head and tail are free-running counters; their difference is the fill
+// level, and the acquire/release pairs order slot contents across cores.
+uint32_t *rsa_spsc_claim(rsa_spsc_ring_t *ring) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= ring->capacity) {
+        return NULL;
+    }
+    return &ring->slots[(head & (ring->capacity - 1)) * ring->slot_words];
+}
+
+void rsa_spsc_publish(rsa_spsc_ring_t *ring) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+uint32_t *rsa_spsc_peek(rsa_spsc_ring_t *ring) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (head == tail) {
+        return NULL;
+    }
+    return &ring->slots[(tail & (ring->capacity - 1)) * ring->slot_words];
+}
+
+void rsa_spsc_release(rsa_spsc_ring_t *ring) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+typedef struct {
+    const rsa_pipeline_cfg_t *cfg;
+    rsa_spsc_ring_t ring;
+    uint32_t *Z;
+    TaskHandle_t caller;
+    // Woken after each release and publish. Both tasks stay alive until
+    // the caller deletes them, so a late notification never reaches a
+    // deleted task. producer is NULL when the caller produces itself.
+    TaskHandle_t producer;
+    TaskHandle_t consumer;
+    rsa_pipeline_result_t *result;
+} pipeline_run_t;
+
+// Blocks until a slot is free, counting one stall per wait rather than per
+// wake-up. Without a producer task to notify, the caller polls per tick.
+static uint32_t *pipeline_claim(pipeline_run_t *run, bool notified) {
+    uint32_t *slot = rsa_spsc_claim(&run->ring);
+    if (slot) {
+        return slot;
+    }
+    run->result->producer_stalls++;
+    while ((slot = rsa_spsc_claim(&run->ring)) == NULL) {
+        if (notified) {
+            (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        } else {
+            vTaskDelay(1);
+        }
+    }
+    return slot;
+}
+
+static void pipeline_produce_all(pipeline_run_t *run, bool notified) {
+    const rsa_pipeline_cfg_t *cfg = run->cfg;
+    for (size_t i = 0; i < cfg->count; i++) {
+        uint32_t *slot = pipeline_claim(run, notified);
+        cfg->produce(slot, cfg->ctx, cfg->arg);
+        rsa_spsc_publish(&run->ring);
+        xTaskNotifyGive(run->consumer);
+    }
+}
+
+// Reports to the caller and parks until it deletes the task
+static void pipeline_task_done(pipeline_run_t *run) {
+    xTaskNotifyGive(run->caller);
+    vTaskSuspend(NULL);
+}
+
+static void pipeline_producer_task(void *arg) {
+    pipeline_run_t *run = (pipeline_run_t *)arg;
+    pipeline_produce_all(run, true);
+    pipeline_task_done(run);
+}
+
+static void pipeline_consumer_task(void *arg) {
+    pipeline_run_t *run = (pipeline_run_t *)arg;
+    const rsa_pipeline_cfg_t *cfg = run->cfg;
+    const size_t words = cfg->ctx->words;
+    bool ok = true;
+
+    for (size_t i = 0; i < cfg->count; i++) {
+        const uint32_t *slot = rsa_spsc_peek(&run->ring);
+        if (!slot) {
+            run->result->consumer_stalls++;
+            while ((slot = rsa_spsc_peek(&run->ring)) == NULL) {
+                (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            }
+        }
+        if (ok) {
+            ok = cfg->plan ? rsa_mod_exp_hw_words(cfg->ctx, slot, cfg->plan, run->Z, false)
+                           : rsa_mod_mult_hw_words(cfg->ctx, slot, slot + words, run->Z);
+        }
+        // Keep draining after a failure so the producer is never left blocked
+        rsa_spsc_release(&run->ring);
+        if (run->producer) {
+            xTaskNotifyGive(run->producer);
+        }
+        if (ok) {
+            if (cfg->sink) {
+                cfg->sink(run->Z, cfg->ctx, cfg->arg);
+            }
+            run->result->completed++;
+        }
+    }
+
+    run->result->ok = ok;
+    pipeline_task_done(run);
+}
+
+bool rsa_pipeline_run(const rsa_pipeline_cfg_t *cfg, rsa_pipeline_result_t *result) {
+    if (!cfg || !cfg->ctx || !cfg->produce || !result) {
+        return false;
+    }
+    memset(result, 0, sizeof(*result));
+
+    pipeline_run_t run = {
+        .cfg = cfg,
+        .caller = xTaskGetCurrentTaskHandle(),
+        .result = result,
+    };
+    size_t slot_words = cfg->ctx->words * (cfg->plan ? 1 : 2);
+    if (!rsa_spsc_init(&run.ring, cfg->ring_capacity, slot_words)) {
+        return false;
+    }
+    run.Z = heap_caps_calloc(cfg->ctx->words, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    if (!run.Z) {
+        rsa_spsc_free(&run.ring);
+        return false;
+    }
+
+    // Drop stale notifications so the waits below only count our tasks
+    (void)ulTaskNotifyTake(pdTRUE, 0);
+
+    // The handles are stored before each task first runs, and the consumer
+    // only notifies the producer once it has published something
+    uint64_t start = esp_timer_get_time();
+    if (xTaskCreatePinnedToCore(pipeline_consumer_task, "rsa_consume", PIPELINE_STACK_BYTES, &run,
+                                PIPELINE_PRIORITY, &run.consumer, cfg->consumer_core) != pdPASS) {
+        heap_caps_free(run.Z);
+        rsa_spsc_free(&run.ring);
+        return false;
+    }
+    size_t tasks = 1;
+    if (xTaskCreatePinnedToCore(pipeline_producer_task, "rsa_produce", PIPELINE_STACK_BYTES, &run,
+                                PIPELINE_PRIORITY, &run.producer, cfg->producer_core) == pdPASS) {
+        tasks++;
+    } else {
+        // The consumer is already waiting on the ring, so produce from here
+        run.producer = NULL;
+        pipeline_produce_all(&run, false);
+    }
+
+    size_t finished = 0;
+    while (finished < tasks) {
+        finished += ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    result->elapsed_us = esp_timer_get_time() - start;
+
+    vTaskDelete(run.consumer);
+    if (run.producer) {
+        vTaskDelete(run.producer);
+    }
+    heap_caps_free(run.Z);
+    rsa_spsc_free(&run.ring);
+    return result->ok;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#include "rsa_hw.h"
+
+// Lock-free single-producer/single-consumer ring of fixed-size word slots.
+// The producer claims a slot, fills it and publishes it; the consumer peeks
+// the oldest published slot and releases it when done. Capacity must be a
+// power of two.
+typedef struct {
+    uint32_t *slots;
+    size_t slot_words;
+    size_t capacity;
+    _Atomic uint32_t head;   // next slot to publish, written by the producer
+    _Atomic uint32_t tail;   // next slot to release, written by the consumer
+} rsa_spsc_ring_t;
+
+bool rsa_spsc_init(rsa_spsc_ring_t *ring, size_t capacity, size_t slot_words);
+void rsa_spsc_free(rsa_spsc_ring_t *ring);
+uint32_t *rsa_spsc_claim(rsa_spsc_ring_t *ring);
+void rsa_spsc_publish(rsa_spsc_ring_t *ring);
+uint32_t *rsa_spsc_peek(rsa_spsc_ring_t *ring);
+void rsa_spsc_release(rsa_spsc_ring_t *ring);
+
+// Fills one operand slot: X in the first ctx->words words and, for modmult,
+// Y in the next ctx->words. Runs on the producer core.
+typedef void (*rsa_pipeline_produce_fn)(uint32_t *slot, const rsa_mont_ctx_t *ctx, void *arg);
+// Receives each result (ctx->words words). Runs on the consumer core.
+typedef void (*rsa_pipeline_sink_fn)(const uint32_t *Z, const rsa_mont_ctx_t *ctx, void *arg);
+
+typedef struct {
+    const rsa_mont_ctx_t *ctx;
+    const rsa_exp_plan_t *plan;     // NULL for modmult
+    size_t count;
+    size_t ring_capacity;
+    rsa_pipeline_produce_fn produce;
+    rsa_pipeline_sink_fn sink;      // optional
+    void *arg;
+    int producer_core;
+    int consumer_core;
+} rsa_pipeline_cfg_t;
+
+typedef struct {
+    size_t completed;
+    uint64_t elapsed_us;
+    size_t producer_stalls;         // waits for a free slot (ring full)
+    size_t consumer_stalls;         // waits for an operand (ring empty)
+    bool ok;
+} rsa_pipeline_result_t;
+
+// Runs cfg->count operations with one task producing operands and another
+// driving the accelerator, each pinned to its own core. Blocks until both
+// tasks finish. A task that finds the ring full or empty blocks on a task
+// notification from the other side instead of spinning, so each core's
+// IDLE task still runs.
+bool rsa_pipeline_run(const rsa_pipeline_cfg_t *cfg, rsa_pipeline_result_t *result);
@@ -1,6 +1,10 @@
 #include "sha_benchmark.h"
+#include "sha_hw.h"
+#include "bench_timer.h"
+#include "bench_stats.h"
 
 #include <stdio.h>
+#include <stdbool.h>
 #include <inttypes.h>
 #include <string.h>
 #include <stdlib.h>
@@ -22,52 +26,125 @@ static void fill_random(uint8_t *buf, size_t len) {
     }
 }
 
-static double measure_sha256_us(const uint8_t *buf, size_t len, size_t iterations) {
+// Average µs per hash, or -1 if the mode is unavailable; *cycles collects
+// the per-hash samples from bench_timer's cycle source, which resolves the
+// short lengths µs cannot.
+static double measure_sha256_us(sha_hw_mode_t mode, const uint8_t *buf, size_t len, size_t iterations,
+                                bench_stats_t *cycles) {
     uint8_t out[32];
     uint64_t total = 0;
 
+    bench_stats_init(cycles);
     for (size_t i = 0; i < iterations; i++) {
-        uint64_t start = esp_timer_get_time();
-        esp_sha(SHA2_256, buf, len, out);
-        uint64_t end = esp_timer_get_time();
-        total += (end - start);
+        bench_timer_t timer;
+        bench_sample_t sample;
+        bench_timer_start(&timer);
+        bool ok = sha256_hw_mode(mode, buf, len, out);
+        bench_timer_stop(&timer, &sample);
+        if (!ok) {
+            return -1.0;
+        }
+        total += sample.us;
+        bench_stats_update(cycles, sample.cycles);
     }
 
     (void)out[0];
     return (iterations > 0) ? ((double)total / (double)iterations) : 0.0;
 }
 
-static double measure_full_domain_us(const uint8_t *buf, size_t len, size_t hashes, size_t iterations) {
+// The k_lengths sweep in one mode, one CSV_SHA256 row per length; the
+// averages go to totals[] for the crossover search
+static bool sha256_lengths_mode(sha_hw_mode_t mode, const uint8_t *buf, size_t iterations, double *totals) {
+    const char *name = sha_hw_mode_name(mode);
+    bench_stats_t cycles;
+    double setup_us = measure_sha256_us(mode, buf, 0, iterations, &cycles);
+    if (setup_us < 0.0) {
+        printf("SHA256 %s mode failed\n", name);
+        return false;
+    }
+    double setup_cycles = bench_stats_avg(&cycles);
+    double mhz = (double)bench_timer_cpu_mhz();
+    printf("SHA256 %s setup (len=0): %.2f us, %.0f cycles\n", name, setup_us, setup_cycles);
+
+    for (size_t i = 0; i < sizeof(k_lengths) / sizeof(k_lengths[0]); i++) {
+        size_t len = k_lengths[i];
+        double total_us = measure_sha256_us(mode, buf, len, iterations, &cycles);
+        if (total_us < 0.0) {
+            printf("SHA256 %s mode failed at %zu bytes\n", name, len);
+            return false;
+        }
+        double total_cycles = bench_stats_avg(&cycles);
+        double per_byte = 0.0;
+        if (len > 0 && total_us > setup_us) {
+            per_byte = (total_us - setup_us) / (double)len;
+        }
+        printf("CSV_SHA256,%zu,%.2f,%.2f,%.6f,%.1f,%.1f,%.1f,%s\n", len, total_us, setup_us, per_byte,
+               total_cycles, mhz > 0.0 ? total_cycles * 1000.0 / mhz : 0.0, setup_cycles, name);
+        bench_stats_csv_hist("sha256", len, name, "cycles", &cycles);
+        totals[i] = total_cycles;
+    }
+    return true;
+}
+
+#if SOC_SHA_SUPPORT_SHA512
+// FDH block k is SHA512(message || k) with a one-byte counter k, so the
+// output is hashes * 64 bytes. Both constructions produce the same blocks.
+typedef bool (*fdh_fn_t)(const uint8_t *buf, size_t len, size_t hashes, uint8_t *out);
+
+// Reference construction: every block rehashes the whole message
+static bool fdh_rehash(const uint8_t *buf, size_t len, size_t hashes, uint8_t *out) {
+    for (size_t k = 0; k < hashes; k++) {
+        mbedtls_sha512_context ctx;
+        mbedtls_sha512_init(&ctx);
+        uint8_t ctr = (uint8_t)k;
+        bool ok = mbedtls_sha512_starts(&ctx, 0) == 0 &&
+                  mbedtls_sha512_update(&ctx, buf, len) == 0 &&
+                  mbedtls_sha512_update(&ctx, &ctr, 1) == 0 &&
+                  mbedtls_sha512_finish(&ctx, out + (k * 64)) == 0;
+        mbedtls_sha512_free(&ctx);
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The message is absorbed once and each block finishes a clone of that
+// midstate with its counter byte. On the ESP32 port a clone of a context
+// holding the hardware engine reads the digest state out and finishes in
+// software, which only costs the final one or two blocks.
+static bool fdh_midstate(const uint8_t *buf, size_t len, size_t hashes, uint8_t *out) {
+    mbedtls_sha512_context base;
+    mbedtls_sha512_init(&base);
+    bool ok = mbedtls_sha512_starts(&base, 0) == 0 && mbedtls_sha512_update(&base, buf, len) == 0;
+    for (size_t k = 0; k < hashes && ok; k++) {
+        mbedtls_sha512_context ctx;
+        mbedtls_sha512_init(&ctx);
+        mbedtls_sha512_clone(&ctx, &base);
+        uint8_t ctr = (uint8_t)k;
+        ok = mbedtls_sha512_update(&ctx, &ctr, 1) == 0 &&
+             mbedtls_sha512_finish(&ctx, out + (k * 64)) == 0;
+        mbedtls_sha512_free(&ctx);
+    }
+    mbedtls_sha512_free(&base);
+    return ok;
+}
+#endif
+
+static double measure_full_domain_us(const uint8_t *buf, size_t len, size_t hashes, size_t iterations,
+                                     bool midstate) {
 #if !SOC_SHA_SUPPORT_SHA512
-    (void)buf; (void)len; (void)hashes; (void)iterations;
+    (void)buf; (void)len; (void)hashes; (void)iterations; (void)midstate;
     return -1.0;
 #else
     uint8_t out[64 * 8];
     uint64_t total = 0;
+    fdh_fn_t fdh = midstate ? fdh_midstate : fdh_rehash;
 
     for (size_t i = 0; i < iterations; i++) {
         uint64_t start = esp_timer_get_time();
-        for (size_t k = 0; k < hashes; k++) {
-            mbedtls_sha512_context ctx;
-            mbedtls_sha512_init(&ctx);
-            if (mbedtls_sha512_starts(&ctx, 0) != 0) {
-                mbedtls_sha512_free(&ctx);
-                return -1.0;
-            }
-            if (mbedtls_sha512_update(&ctx, buf, len) != 0) {
-                mbedtls_sha512_free(&ctx);
-                return -1.0;
-            }
-            uint8_t ctr = (uint8_t)k;
-            if (mbedtls_sha512_update(&ctx, &ctr, 1) != 0) {
-                mbedtls_sha512_free(&ctx);
-                return -1.0;
-            }
-            if (mbedtls_sha512_finish(&ctx, out + (k * 64)) != 0) {
-                mbedtls_sha512_free(&ctx);
-                return -1.0;
-            }
-            mbedtls_sha512_free(&ctx);
+        if (!fdh(buf, len, hashes, out)) {
+            return -1.0;
         }
         uint64_t end = esp_timer_get_time();
         total += (end - start);
@@ -78,10 +155,25 @@ static double measure_full_domain_us(const uint8_t *buf, size_t len, size_t hash
 #endif
 }
 
+// Both constructions on the same message must give the same output
+static bool full_domain_outputs_match(const uint8_t *buf, size_t len, size_t hashes) {
+#if !SOC_SHA_SUPPORT_SHA512
+    (void)buf; (void)len; (void)hashes;
+    return false;
+#else
+    uint8_t a[64 * 8];
+    uint8_t b[64 * 8];
+    return fdh_rehash(buf, len, hashes, a) && fdh_midstate(buf, len, hashes, b) &&
+           memcmp(a, b, hashes * 64) == 0;
+#endif
+}
+
 void benchmark_sha256_lengths(size_t iterations) {
+    const size_t n = sizeof(k_lengths) / sizeof(k_lengths[0]);
     printf("\n══════════════════════════════════════════\n");
     printf("SHA256 Hardware Benchmark (setup + per-byte)\n");
     printf("Lengths: 32..16384 bytes\n");
+    printf("Modes: block%s\n", sha_hw_dma_supported() ? ", dma, auto" : " (no SHA DMA on this target)");
     printf("Iterations: %zu\n", iterations);
     printf("══════════════════════════════════════════\n");
 
@@ -92,19 +184,42 @@ void benchmark_sha256_lengths(size_t iterations) {
     }
     fill_random(buf, MAX_INPUT_LEN);
 
-    double setup_us = measure_sha256_us(buf, 0, iterations);
+    printf("CSV_SHA256_HEADER,len,total_us,setup_us,per_byte_us,total_cycles,total_ns,setup_cycles,mode\n");
+    double block_cycles[sizeof(k_lengths) / sizeof(k_lengths[0])];
+    double dma_cycles[sizeof(k_lengths) / sizeof(k_lengths[0])];
+    bool ok = sha256_lengths_mode(SHA_HW_BLOCK, buf, iterations, block_cycles);
 
-    printf("CSV_SHA256_HEADER,len,total_us,setup_us,per_byte_us\n");
-    printf("SHA256 setup (len=0): %.2f us\n", setup_us);
+    if (ok && sha_hw_dma_supported()) {
+        uint8_t ref[32];
+        uint8_t out[32];
+        // Same digest from both modes, at a length with a partial tail block
+        bool match = sha256_hw_mode(SHA_HW_BLOCK, buf, 1000, ref) &&
+                     sha256_hw_mode(SHA_HW_DMA, buf, 1000, out) && memcmp(ref, out, sizeof(ref)) == 0;
+        printf("DMA digest check vs block mode: %s\n", match ? "✓" : "MISMATCH");
+        ok = match && sha256_lengths_mode(SHA_HW_DMA, buf, iterations, dma_cycles);
+    }
 
-    for (size_t i = 0; i < sizeof(k_lengths) / sizeof(k_lengths[0]); i++) {
-        size_t len = k_lengths[i];
-        double total_us = measure_sha256_us(buf, len, iterations);
-        double per_byte = 0.0;
-        if (len > 0 && total_us > setup_us) {
-            per_byte = (total_us - setup_us) / (double)len;
+    if (ok && sha_hw_dma_supported()) {
+        // Crossover: the shortest length from which DMA wins at every
+        // longer length too
+        size_t cross = n;
+        while (cross > 0 && dma_cycles[cross - 1] < block_cycles[cross - 1]) {
+            cross--;
+        }
+        printf("CSV_SHA256_CROSSOVER_HEADER,len,block_cycles,dma_cycles\n");
+        if (cross < n) {
+            sha_hw_set_dma_crossover(k_lengths[cross]);
+            printf("DMA beats block mode from %zu bytes\n", k_lengths[cross]);
+            printf("CSV_SHA256_CROSSOVER,%zu,%.1f,%.1f\n", k_lengths[cross], block_cycles[cross],
+                   dma_cycles[cross]);
+        } else {
+            sha_hw_set_dma_crossover(SIZE_MAX);
+            printf("DMA never beats block mode up to %zu bytes\n", k_lengths[n - 1]);
+            printf("CSV_SHA256_CROSSOVER,none,,\n");
         }
-        printf("CSV_SHA256,%zu,%.2f,%.2f,%.6f\n", len, total_us, setup_us, per_byte);
+        // The dispatcher with the measured crossover
+        double auto_cycles[sizeof(k_lengths) / sizeof(k_lengths[0])];
+        sha256_lengths_mode(SHA_HW_AUTO, buf, iterations, auto_cycles);
     }
 
     free(buf);
@@ -140,7 +255,7 @@ void benchmark_full_domain_hash(size_t output_bits, size_t iterations) {
     }
     fill_random(buf, MAX_INPUT_LEN);
 
-    double setup_us = measure_full_domain_us(buf, 0, hashes, iterations);
+    double setup_us = measure_full_domain_us(buf, 0, hashes, iterations, false);
     if (setup_us < 0.0) {
         printf("Full-domain hash measurement failed\n");
         free(buf);
@@ -148,11 +263,12 @@ void benchmark_full_domain_hash(size_t output_bits, size_t iterations) {
     }
 
     printf("CSV_FDH_HEADER,output_bits,len,total_us,setup_us,per_byte_us,bytes_processed\n");
+    printf("CSV_FDH_MIDSTATE_HEADER,output_bits,len,rehash_us,midstate_us,speedup,match\n");
     printf("FDH setup (len=0, %zu hashes): %.2f us\n", hashes, setup_us);
 
     for (size_t i = 0; i < sizeof(k_lengths) / sizeof(k_lengths[0]); i++) {
         size_t len = k_lengths[i];
-        double total_us = measure_full_domain_us(buf, len, hashes, iterations);
+        double total_us = measure_full_domain_us(buf, len, hashes, iterations, false);
         double per_byte = 0.0;
         size_t bytes_processed = hashes * (len + 1); // +1 counter byte per hash
         if (bytes_processed > 0 && total_us > setup_us) {
@@ -160,7 +276,93 @@ void benchmark_full_domain_hash(size_t output_bits, size_t iterations) {
         }
         printf("CSV_FDH,%zu,%zu,%.2f,%.2f,%.6f,%zu\n",
                output_bits, len, total_us, setup_us, per_byte, bytes_processed);
+
+        // Same output from one pass over the message plus a cloned finish per block
+        bool match = full_domain_outputs_match(buf, len, hashes);
+        double midstate_us = measure_full_domain_us(buf, len, hashes, iterations, true);
+        printf("CSV_FDH_MIDSTATE,%zu,%zu,%.2f,%.2f,%.2f,%d\n", output_bits, len, total_us, midstate_us,
+               midstate_us > 0.0 ? total_us / midstate_us : 0.0, match ? 1 : 0);
     }
 
     free(buf);
 }
+
+#define BATCH_MAX 256
+
+static const size_t k_batch_lengths[] = {32, 64, 128};
+static const size_t k_batch_sizes[] = {1, 4, 16, 64, BATCH_MAX};
+
+// Per-message cost of short SHA256 messages against batch size: one
+// esp_sha() per message versus sha256_hw_batch over the same messages,
+// which acquires the engine once per batch
+void benchmark_sha256_batch(size_t iterations) {
+    printf("\n══════════════════════════════════════════\n");
+    printf("SHA256 Batch Benchmark (one engine acquisition per batch)\n");
+    printf("Lengths: 32, 64, 128 bytes; batches 1..%d\n", BATCH_MAX);
+    printf("Iterations: %zu\n", iterations);
+    printf("══════════════════════════════════════════\n");
+
+    uint8_t *msgs = (uint8_t *)malloc(BATCH_MAX * 128);
+    uint8_t *ref = (uint8_t *)malloc(BATCH_MAX * 32);
+    uint8_t *digests = (uint8_t *)malloc(BATCH_MAX * 32);
+    const uint8_t **ptrs = (const uint8_t **)malloc(BATCH_MAX * sizeof(*ptrs));
+    size_t *lens = (size_t *)malloc(BATCH_MAX * sizeof(*lens));
+    if (!msgs || !ref || !digests || !ptrs || !lens) {
+        printf("Memory allocation failed\n");
+        free(msgs);
+        free(ref);
+        free(digests);
+        free(ptrs);
+        free(lens);
+        return;
+    }
+    fill_random(msgs, BATCH_MAX * 128);
+
+    printf("CSV_SHA256_BATCH_HEADER,len,batch,iter,single_ns,batch_ns,speedup,match\n");
+    for (size_t li = 0; li < sizeof(k_batch_lengths) / sizeof(k_batch_lengths[0]); li++) {
+        size_t len = k_batch_lengths[li];
+        for (size_t m = 0; m < BATCH_MAX; m++) {
+            ptrs[m] = msgs + m * len;
+            lens[m] = len;
+        }
+
+        for (size_t bi = 0; bi < sizeof(k_batch_sizes) / sizeof(k_batch_sizes[0]); bi++) {
+            size_t batch = k_batch_sizes[bi];
+            bench_stats_t single, batched;
+            bench_stats_init(&single);
+            bench_stats_init(&batched);
+            bool ok = true;
+
+            for (size_t i = 0; i < iterations && ok; i++) {
+                bench_timer_t timer;
+                bench_sample_t sample;
+                bench_timer_start(&timer);
+                for (size_t m = 0; m < batch; m++) {
+                    esp_sha(SHA2_256, ptrs[m], len, ref + 32 * m);
+                }
+                bench_timer_stop(&timer, &sample);
+                bench_stats_update(&single, sample.ns);
+
+                bench_timer_start(&timer);
+                ok = sha256_hw_batch(ptrs, lens, batch, digests);
+                bench_timer_stop(&timer, &sample);
+                bench_stats_update(&batched, sample.ns);
+            }
+
+            // Digests of the last round, batch against one call per message
+            bool match = ok && memcmp(ref, digests, batch * 32) == 0;
+            double single_ns = bench_stats_avg(&single) / (double)batch;
+            double batch_ns = bench_stats_avg(&batched) / (double)batch;
+            printf("  %3zu bytes x %3zu: %.0f ns/msg single, %.0f ns/msg batched%s\n", len, batch, single_ns,
+                   batch_ns, match ? "" : " (MISMATCH)");
+            printf("CSV_SHA256_BATCH,%zu,%zu,%zu,%.1f,%.1f,%.2f,%d\n", len, batch, iterations, single_ns,
+                   batch_ns, batch_ns > 0.0 ? single_ns / batch_ns : 0.0, match ? 1 : 0);
+        }
+    }
+
+    free(msgs);
+    free(ref);
+    free(digests);
+    free(ptrs);
+    free(lens);
+}
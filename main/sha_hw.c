@@ -0,0 +1,178 @@
+#include "sha_hw.h"
+
+#include <string.h>
+
+#include "soc/soc_caps.h"
+#include "sha/sha_core.h"
+
+#if SOC_SHA_SUPPORT_PARALLEL_ENG
+#include "sha/sha_parallel_engine.h"
+#endif
+
+#if SOC_SHA_SUPPORT_DMA
+static size_t s_dma_crossover = SHA_HW_DMA_CROSSOVER_DEFAULT;
+#else
+static size_t s_dma_crossover = SIZE_MAX;
+#endif
+
+bool sha_hw_dma_supported(void) {
+#if SOC_SHA_SUPPORT_DMA
+    return true;
+#else
+    return false;
+#endif
+}
+
+const char *sha_hw_mode_name(sha_hw_mode_t mode) {
+    switch (mode) {
+    case SHA_HW_BLOCK:
+        return "block";
+    case SHA_HW_DMA:
+        return "dma";
+    case SHA_HW_AUTO:
+        return "auto";
+    }
+    return "?";
+}
+
+void sha_hw_set_dma_crossover(size_t len) {
+    s_dma_crossover = sha_hw_dma_supported() ? len : SIZE_MAX;
+}
+
+size_t sha_hw_dma_crossover(void) {
+    return s_dma_crossover;
+}
+
+// SHA256 padding after the last rem (< 64) bytes of a len-byte message:
+// 0x80, zeros, then the 64-bit big-endian bit length. Fills one or two
+// blocks of tail and returns how many bytes of it to hash.
+static size_t sha256_pad_tail(uint8_t tail[128], const uint8_t *rest, size_t rem, size_t len) {
+    size_t tail_len = (rem < 56) ? 64 : 128;
+    memset(tail, 0, 128);
+    memcpy(tail, rest, rem);
+    tail[rem] = 0x80;
+    uint64_t bit_len = (uint64_t)len * 8;
+    for (size_t i = 0; i < 8; i++) {
+        tail[tail_len - 1 - i] = (uint8_t)(bit_len >> (8 * i));
+    }
+    return tail_len;
+}
+
+#if SOC_SHA_SUPPORT_DMA
+// The whole blocks go to the engine straight from buf; the remainder and
+// the padding follow from a local one- or two-block buffer. The digest registers hold the
+// output bytes in order once the last block is done.
+static bool sha256_dma(const uint8_t *buf, size_t len, uint8_t out[32]) {
+    size_t whole = len & ~(size_t)63;
+    uint8_t tail[128];
+    size_t tail_len = sha256_pad_tail(tail, buf + whole, len - whole, len);
+
+    esp_sha_acquire_hardware();
+    bool ok = (whole == 0 || esp_sha_dma(SHA2_256, buf, whole, NULL, 0, true) == 0) &&
+              esp_sha_dma(SHA2_256, tail, tail_len, NULL, 0, whole == 0) == 0;
+    if (ok) {
+        esp_sha_read_digest_state(SHA2_256, out);
+    }
+    esp_sha_release_hardware();
+    return ok;
+}
+#endif
+
+bool sha256_hw_mode(sha_hw_mode_t mode, const uint8_t *buf, size_t len, uint8_t out[32]) {
+    if (mode == SHA_HW_AUTO) {
+        mode = (len >= s_dma_crossover) ? SHA_HW_DMA : SHA_HW_BLOCK;
+    }
+    if (mode == SHA_HW_DMA) {
+#if SOC_SHA_SUPPORT_DMA
+        return sha256_dma(buf, len, out);
+#else
+        return false;
+#endif
+    }
+    esp_sha(SHA2_256, buf, len, out);
+    return true;
+}
+
+bool sha256_hw(const uint8_t *buf, size_t len, uint8_t out[32]) {
+    return sha256_hw_mode(SHA_HW_AUTO, buf, len, out);
+}
+
+#if SOC_SHA_SUPPORT_PARALLEL_ENG
+// The parallel engine's digest state is native-endian words, which the
+// IDF port writes out big-endian; the other ports read it back in output
+// byte order
+static bool sha_engine_acquire(void) {
+    return esp_sha_try_lock_engine(SHA2_256);
+}
+
+static void sha_engine_release(void) {
+    esp_sha_unlock_engine(SHA2_256);
+}
+
+static void sha256_put_digest(uint8_t *out) {
+    uint32_t state[8];
+    esp_sha_read_digest_state(SHA2_256, state);
+    for (size_t i = 0; i < 8; i++) {
+        out[4 * i] = (uint8_t)(state[i] >> 24);
+        out[4 * i + 1] = (uint8_t)(state[i] >> 16);
+        out[4 * i + 2] = (uint8_t)(state[i] >> 8);
+        out[4 * i + 3] = (uint8_t)state[i];
+    }
+}
+#else
+static bool sha_engine_acquire(void) {
+    esp_sha_acquire_hardware();
+    return true;
+}
+
+static void sha_engine_release(void) {
+    esp_sha_release_hardware();
+}
+
+static void sha256_put_digest(uint8_t *out) {
+    esp_sha_read_digest_state(SHA2_256, out);
+}
+#endif
+
+bool sha256_hw_batch(const uint8_t *const *msgs, const size_t *lens, size_t count, uint8_t *digests) {
+    // Word-aligned staging for the engine's block loads
+    uint32_t block[16];
+    uint32_t tail_words[32];
+    uint8_t *tail = (uint8_t *)tail_words;
+
+    if (count == 0) {
+        return true;
+    }
+    if (!msgs || !lens || !digests) {
+        return false;
+    }
+    // The parallel engine may already be held by another SHA256 user
+    if (!sha_engine_acquire()) {
+        return false;
+    }
+    bool ok = true;
+    for (size_t m = 0; m < count && ok; m++) {
+        const uint8_t *msg = msgs[m];
+        size_t len = lens[m];
+        if (!msg && len > 0) {
+            ok = false;
+            break;
+        }
+        size_t whole = len & ~(size_t)63;
+        bool first = true;
+
+        for (size_t off = 0; off < whole; off += 64) {
+            memcpy(block, msg + off, 64);
+            esp_sha_block(SHA2_256, block, first);
+            first = false;
+        }
+        size_t tail_len = sha256_pad_tail(tail, msg + whole, len - whole, len);
+        for (size_t off = 0; off < tail_len; off += 64) {
+            esp_sha_block(SHA2_256, tail + off, first);
+            first = false;
+        }
+        sha256_put_digest(digests + 32 * m);
+    }
+    sha_engine_release();
+    return ok;
+}
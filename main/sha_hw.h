@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// SHA256 on the SHA engine in one of two modes:
+// - SHA_HW_BLOCK: esp_sha(), the CPU feeds the engine block by block.
+// - SHA_HW_DMA: the engine streams the message from memory over GDMA, on
+//   targets with SOC_SHA_SUPPORT_DMA; only the padded tail is copied.
+// sha256_hw() dispatches on length: messages of at least the DMA crossover
+// go to DMA, shorter ones (and everything on targets without DMA) to
+// block mode. benchmark_sha256_lengths measures the crossover and sets it.
+typedef enum {
+    SHA_HW_BLOCK,
+    SHA_HW_DMA,
+    SHA_HW_AUTO,
+} sha_hw_mode_t;
+
+// Used until a benchmark sets a measured crossover
+#define SHA_HW_DMA_CROSSOVER_DEFAULT 1024
+
+bool sha_hw_dma_supported(void);
+const char *sha_hw_mode_name(sha_hw_mode_t mode);
+
+// false when the mode is unavailable on this target or the engine failed
+bool sha256_hw_mode(sha_hw_mode_t mode, const uint8_t *buf, size_t len, uint8_t out[32]);
+bool sha256_hw(const uint8_t *buf, size_t len, uint8_t out[32]);
+
+// SIZE_MAX keeps every length on block mode
+void sha_hw_set_dma_crossover(size_t len);
+size_t sha_hw_dma_crossover(void);
+
+// Hashes count messages with the engine acquired once for the whole batch
+// and one padding buffer reused across messages, instead of an esp_sha()
+// acquire / init / release per message. Digest i goes to digests + 32 * i.
+// Meant for many short messages (Merkle nodes, commitments); always runs in
+// block mode. Returns false on a NULL message with a non-zero length, or
+// when the engine is held elsewhere (the ESP32 parallel engine is taken
+// with a try-lock); digests before the failing message are written.
+bool sha256_hw_batch(const uint8_t *const *msgs, const size_t *lens, size_t count, uint8_t *digests);
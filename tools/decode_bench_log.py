@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""Expand CSV_BLOG frames from a benchmark log into CSV / CSV_CYC rows.
+
+Reads the serial capture from the given file (or stdin) and writes it back
+with every CSV_BLOG line replaced by the rows bench_log would have printed
+in CSV mode. Other lines pass through unchanged. Frames with a bad CRC are
+reported on stderr and dropped.
+"""
+
+import base64
+import struct
+import sys
+import zlib
+
+FLAG_CYCLES = 0x1
+FLAG_ESP_TIMER = 0x2
+
+
+def decode_frame(line):
+    fields = line.rstrip("\r\n").split(",")
+    if len(fields) != 10:
+        raise ValueError("expected 10 fields, got %d" % len(fields))
+    _, op, bits, exp, flags, mhz, first_iter, count, payload, crc = fields
+    flags, mhz = int(flags), int(mhz)
+    first_iter, count = int(first_iter), int(count)
+    raw = base64.b64decode(payload)
+    if zlib.crc32(raw) != int(crc, 16):
+        raise ValueError("CRC mismatch")
+
+    cycles = bool(flags & FLAG_CYCLES)
+    entry = struct.Struct("<IQ" if cycles else "<I")
+    if len(raw) != entry.size * count:
+        raise ValueError("payload is %d bytes, expected %d" % (len(raw), entry.size * count))
+
+    rows = []
+    for i, values in enumerate(entry.iter_unpack(raw)):
+        it = first_iter + i
+        us = values[0]
+        rows.append("CSV,%s,%s,%s,%d,%d" % (op, bits, exp, it, us))
+        if cycles:
+            cyc = values[1]
+            if flags & FLAG_ESP_TIMER:
+                ns = us * 1000
+            else:
+                ns = cyc * 1000 // mhz if mhz else 0
+            rows.append("CSV_CYC,%s,%s,%s,%d,%d,%d,%d" % (op, bits, exp, it, us, cyc, ns))
+    return rows
+
+
+def main(argv):
+    src = open(argv[1], encoding="utf-8", errors="replace") if len(argv) > 1 else sys.stdin
+    bad = 0
+    with src:
+        for lineno, line in enumerate(src, 1):
+            if not line.startswith("CSV_BLOG,"):
+                sys.stdout.write(line)
+                continue
+            try:
+                for row in decode_frame(line):
+                    print(row)
+            except ValueError as e:
+                bad += 1
+                print("line %d: dropped CSV_BLOG frame: %s" % (lineno, e), file=sys.stderr)
+    return 1 if bad else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))